@@ -0,0 +1,70 @@
+#if __cpp_exceptions
+
+#include "dedic_gpio_cxx.hpp"
+
+#if SOC_DEDICATED_GPIO_SUPPORTED
+
+#include <cassert>
+#include <vector>
+
+namespace idf {
+
+#define GPIO_CHECK_THROW(err) CHECK_THROW_SPECIFIC((err), GPIOException)
+
+DedicatedGPIOBundle::DedicatedGPIOBundle(std::span<const GPIONum> pins, Mode mode)
+    : _handle(nullptr)
+    , _out_mask(0u)
+    , _out_offset(0u)
+    , _in_mask(0u)
+    , _in_offset(0u)
+{
+    if (pins.empty())
+        throw GPIOException(ESP_ERR_INVALID_ARG);
+    const bool output = mode != Mode::INPUT;
+    const bool input = mode != Mode::OUTPUT;
+
+    std::vector<int> gpio_array;
+    gpio_array.reserve(pins.size());
+    uint64_t pin_bit_mask = 0u;
+    for (const GPIONum & pin : pins) {
+        gpio_array.push_back(pin.get_value<int>());
+        pin_bit_mask |= 1ull << pin.get_value();
+    }
+
+    gpio_config_t io_config = {};
+    io_config.pin_bit_mask = pin_bit_mask;
+    io_config.mode = output ? (input ? GPIO_MODE_INPUT_OUTPUT : GPIO_MODE_OUTPUT) : GPIO_MODE_INPUT;
+    io_config.pull_up_en = GPIO_PULLUP_DISABLE;
+    io_config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    io_config.intr_type = GPIO_INTR_DISABLE;
+    GPIO_CHECK_THROW(gpio_config(&io_config));
+
+    dedic_gpio_bundle_config_t bundle_config = {};
+    bundle_config.gpio_array = gpio_array.data();
+    bundle_config.array_size = gpio_array.size();
+    bundle_config.flags.in_en = input ? 1u : 0u;
+    bundle_config.flags.out_en = output ? 1u : 0u;
+    GPIO_CHECK_THROW(dedic_gpio_new_bundle(&bundle_config, &_handle));
+
+    // The masks stay 0 for a disabled direction, so that write() or read() has no effect
+    if (output) {
+        dedic_gpio_get_out_mask(_handle, &_out_mask);
+        dedic_gpio_get_out_offset(_handle, &_out_offset);
+    }
+    if (input) {
+        dedic_gpio_get_in_mask(_handle, &_in_mask);
+        dedic_gpio_get_in_offset(_handle, &_in_offset);
+    }
+}
+
+DedicatedGPIOBundle::~DedicatedGPIOBundle()
+{
+    [[maybe_unused]] esp_err_t ret = dedic_gpio_del_bundle(_handle);
+    assert(ret == ESP_OK);
+}
+
+} // idf
+
+#endif // SOC_DEDICATED_GPIO_SUPPORTED
+
+#endif
@@ -0,0 +1,215 @@
+#include <chrono>
+#include "esp_event_cxx.hpp"
+#include "esp_event_api.hpp"
+
+#ifdef __cpp_exceptions
+
+using namespace std;
+
+namespace idf {
+
+namespace event {
+
+ESPEventAPIHost::ESPEventAPIHost(size_t queue_size)
+    : queue_size(queue_size),
+    queue_mutex(),
+    not_empty(),
+    not_full(),
+    events(),
+    stopping(false),
+    handlers_mutex(),
+    handlers(),
+    dispatching(false),
+    thread()
+{
+    if (queue_size == 0) {
+        throw EventException(ESP_ERR_INVALID_ARG);
+    }
+
+    thread = std::thread(&ESPEventAPIHost::run, this);
+}
+
+ESPEventAPIHost::~ESPEventAPIHost()
+{
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    not_empty.notify_one();
+    not_full.notify_all();
+    thread.join();
+}
+
+esp_err_t ESPEventAPIHost::handler_register(esp_event_base_t event_base,
+        int32_t event_id,
+        esp_event_handler_t event_handler,
+        void *event_handler_arg,
+        esp_event_handler_instance_t *instance)
+{
+    if (event_handler == nullptr || (event_base == ESP_EVENT_ANY_BASE && event_id != ESP_EVENT_ANY_ID)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    lock_guard<recursive_mutex> lock(handlers_mutex);
+    handlers.push_back(Handler{event_base, event_id, event_handler, event_handler_arg});
+    if (instance != nullptr) {
+        *instance = &handlers.back();
+    }
+    return ESP_OK;
+}
+
+esp_err_t ESPEventAPIHost::handler_unregister(esp_event_base_t event_base,
+        int32_t event_id,
+        esp_event_handler_instance_t instance)
+{
+    lock_guard<recursive_mutex> lock(handlers_mutex);
+    for (auto it = handlers.begin(); it != handlers.end(); ++it) {
+        if (&*it != instance || it->handler == nullptr) {
+            continue;
+        }
+        if (it->base != event_base || it->id != event_id) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (dispatching) {
+            // Only the loop thread can get here during a dispatch, which iterates the list
+            it->handler = nullptr;
+        } else {
+            handlers.erase(it);
+        }
+        return ESP_OK;
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t ESPEventAPIHost::post(esp_event_base_t event_base,
+        int32_t event_id,
+        void* event_data,
+        size_t event_data_size,
+        TickType_t ticks_to_wait)
+{
+    if (event_base == ESP_EVENT_ANY_BASE || event_id == ESP_EVENT_ANY_ID) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    Event event{event_base, event_id, {}};
+    if (event_data != nullptr && event_data_size != 0) {
+        const uint8_t *data = static_cast<const uint8_t*>(event_data);
+        event.data.assign(data, data + event_data_size);
+    }
+
+    unique_lock<mutex> lock(queue_mutex);
+    esp_err_t result = wait_for_room(lock, 1, ticks_to_wait);
+    if (result != ESP_OK) {
+        return result;
+    }
+
+    events.push_back(std::move(event));
+    lock.unlock();
+    not_empty.notify_one();
+    return ESP_OK;
+}
+
+esp_err_t ESPEventAPIHost::post_batch(const ESPEventBatchItem *items,
+        size_t count,
+        TickType_t ticks_to_wait)
+{
+    if (count > queue_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    vector<Event> batch;
+    batch.reserve(count);
+    for (const ESPEventBatchItem *item = items; item != items + count; item++) {
+        if (item->event.base == ESP_EVENT_ANY_BASE || item->event.id.get_id() == ESP_EVENT_ANY_ID) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        batch.push_back(Event{item->event.base, item->event.id.get_id(), {}});
+        if (item->data != nullptr && item->data_size != 0) {
+            const uint8_t *data = static_cast<const uint8_t*>(item->data);
+            batch.back().data.assign(data, data + item->data_size);
+        }
+    }
+
+    unique_lock<mutex> lock(queue_mutex);
+    esp_err_t result = wait_for_room(lock, count, ticks_to_wait);
+    if (result != ESP_OK) {
+        return result;
+    }
+
+    for (Event &event : batch) {
+        events.push_back(std::move(event));
+    }
+    lock.unlock();
+    not_empty.notify_one();
+    return ESP_OK;
+}
+
+esp_err_t ESPEventAPIHost::wait_for_room(unique_lock<mutex> &lock, size_t count, TickType_t ticks_to_wait)
+{
+    auto has_room = [this, count]() { return events.size() + count <= queue_size || stopping; };
+    if (ticks_to_wait == portMAX_DELAY) {
+        not_full.wait(lock, has_room);
+    } else if (!not_full.wait_for(lock,
+            chrono::milliseconds(static_cast<int64_t>(ticks_to_wait) * portTICK_PERIOD_MS),
+            has_room)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (stopping) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+void ESPEventAPIHost::run()
+{
+    unique_lock<mutex> lock(queue_mutex);
+    while (true) {
+        not_empty.wait(lock, [this]() { return !events.empty() || stopping; });
+        if (stopping) {
+            return;
+        }
+
+        Event event = std::move(events.front());
+        events.pop_front();
+        lock.unlock();
+        // Posters wait for room for a whole batch, so wake them all: the first one may need more room than was freed
+        not_full.notify_all();
+
+        {
+            lock_guard<recursive_mutex> handlers_lock(handlers_mutex);
+            dispatch(event);
+        }
+
+        lock.lock();
+    }
+}
+
+void ESPEventAPIHost::dispatch(Event &event)
+{
+    void *data = event.data.empty() ? nullptr : event.data.data();
+
+    dispatching = true;
+    // Like esp_event, a handler registered by one of the handlers is only called from the next event. Nothing is
+    // erased during the dispatch, so the handlers to call are the first ones of the list.
+    auto it = handlers.begin();
+    for (size_t count = handlers.size(); count > 0; count--, ++it) {
+        Handler &handler = *it;
+        if (handler.handler == nullptr
+                || (handler.base != ESP_EVENT_ANY_BASE && handler.base != event.base)
+                || (handler.id != ESP_EVENT_ANY_ID && handler.id != event.id)) {
+            continue;
+        }
+        handler.handler(handler.arg, event.base, event.id, data);
+    }
+    dispatching = false;
+
+    handlers.remove_if([](const Handler &handler) { return handler.handler == nullptr; });
+}
+
+} // event
+
+} // idf
+
+#endif // __cpp_exceptions
@@ -33,7 +33,15 @@ ESPEventReg::ESPEventReg(std::function<void(const ESPEvent &, void*)> cb,
 
 ESPEventReg::~ESPEventReg()
 {
-    api->handler_unregister(event.base, event.id.get_id(), instance);
+    unregister();
+}
+
+void ESPEventReg::unregister()
+{
+    if (instance != nullptr) {
+        api->handler_unregister(event.base, event.id.get_id(), instance);
+        instance = nullptr;
+    }
 }
 
 void ESPEventReg::dispatch_event_handling(ESPEvent event, void *event_data)
@@ -142,6 +150,33 @@ void ESPEventLoop::post_event_data(const ESPEvent &event,
     }
 }
 
+void ESPEventLoop::post_batch(std::span<const ESPEventBatchItem> events,
+        const chrono::milliseconds &wait_time)
+{
+    esp_err_t result = api->post_batch(events.data(), events.size(), convert_ms_to_ticks(wait_time));
+
+    if (result != ESP_OK) {
+        throw ESPException(result);
+    }
+}
+
+esp_err_t ESPEventAPI::post_batch(const ESPEventBatchItem *items,
+        size_t count,
+        TickType_t ticks_to_wait)
+{
+    for (const ESPEventBatchItem *item = items; item != items + count; item++) {
+        esp_err_t result = post(item->event.base,
+                item->event.id.get_id(),
+                const_cast<void*>(item->data),
+                item->data_size,
+                ticks_to_wait);
+        if (result != ESP_OK) {
+            return result;
+        }
+    }
+    return ESP_OK;
+}
+
 TickType_t convert_ms_to_ticks(const std::chrono::milliseconds &time)
 {
     return time.count() / portTICK_PERIOD_MS;
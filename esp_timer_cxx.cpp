@@ -6,6 +6,7 @@
 
 #ifdef __cpp_exceptions
 
+#include <algorithm>
 #include <functional>
 #include "esp_timer_cxx.hpp"
 #include "esp_exception.hpp"
@@ -16,18 +17,58 @@ namespace idf {
 
 namespace esp_timer {
 
-ESPTimer::ESPTimer(function<void()> timeout_cb, const string &timer_name)
-    : timeout_cb(timeout_cb), name(timer_name)
+ESPTimer::ESPTimer(function<void()> timeout_cb, const string &timer_name, bool skip_unhandled_events)
+    : timeout_cb(timeout_cb), name_storage(timer_name), name(name_storage.c_str())
 {
     if (timeout_cb == nullptr) {
         throw ESPException(ESP_ERR_INVALID_ARG);
     }
 
+    create(esp_timer_cb, ESP_TIMER_TASK, skip_unhandled_events);
+}
+
+ESPTimer::ESPTimer(function<void()> timeout_cb, StaticName timer_name, bool skip_unhandled_events)
+    : timeout_cb(timeout_cb), name_storage(), name(timer_name.get())
+{
+    if (timeout_cb == nullptr) {
+        throw ESPException(ESP_ERR_INVALID_ARG);
+    }
+
+    create(esp_timer_cb, ESP_TIMER_TASK, skip_unhandled_events);
+}
+
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+ESPTimer::ESPTimer(ISRCallback isr_cb, void *arg, const string &timer_name, bool skip_unhandled_events)
+    : timeout_cb(), isr_cb(isr_cb), isr_arg(arg), name_storage(timer_name), name(name_storage.c_str())
+{
+    if (isr_cb == nullptr) {
+        throw ESPException(ESP_ERR_INVALID_ARG);
+    }
+
+    create(esp_timer_isr_cb, ESP_TIMER_ISR, skip_unhandled_events);
+}
+
+ESPTimer::ESPTimer(ISRCallback isr_cb, void *arg, StaticName timer_name, bool skip_unhandled_events)
+    : timeout_cb(), isr_cb(isr_cb), isr_arg(arg), name_storage(), name(timer_name.get())
+{
+    if (isr_cb == nullptr) {
+        throw ESPException(ESP_ERR_INVALID_ARG);
+    }
+
+    create(esp_timer_isr_cb, ESP_TIMER_ISR, skip_unhandled_events);
+}
+#endif
+
+void ESPTimer::create(esp_timer_cb_t callback, esp_timer_dispatch_t dispatch_method, bool skip_unhandled_events)
+{
+    this->skip_unhandled_events = skip_unhandled_events;
+
     esp_timer_create_args_t timer_args = {};
-    timer_args.callback = esp_timer_cb;
+    timer_args.callback = callback;
     timer_args.arg = this;
-    timer_args.dispatch_method = ESP_TIMER_TASK;
-    timer_args.name = name.c_str();
+    timer_args.dispatch_method = dispatch_method;
+    timer_args.name = name;
+    timer_args.skip_unhandled_events = skip_unhandled_events;
 
     CHECK_THROW(esp_timer_create(&timer_args, &timer_handle));
 }
@@ -37,13 +78,136 @@ ESPTimer::~ESPTimer()
     // Ignore potential ESP_ERR_INVALID_STATE here to not throw exception.
     esp_timer_stop(timer_handle);
     esp_timer_delete(timer_handle);
+    if (inline_destroy != nullptr) {
+        inline_destroy(inline_callback);
+    }
+}
+
+void ESPTimer::enable_stats()
+{
+    if (is_active()) {
+        throw ESPException(ESP_ERR_INVALID_STATE);
+    }
+    if (!stats_state) {
+        stats_state = make_unique<StatsState>();
+    }
+}
+
+ESPTimer::Stats ESPTimer::get_stats() const
+{
+    if (!stats_state) {
+        throw ESPException(ESP_ERR_INVALID_STATE);
+    }
+
+    lock_guard<mutex> lock(stats_state->mutex);
+    Stats stats = {};
+    stats.calls = stats_state->calls;
+    stats.missed_periods = stats_state->missed_periods;
+    stats.max_lateness = chrono::microseconds(stats_state->max_lateness_us);
+    stats.max_execution_time = chrono::microseconds(stats_state->max_execution_us);
+    if (stats_state->periodic_calls != 0) {
+        stats.mean_lateness = chrono::microseconds(stats_state->total_lateness_us / stats_state->periodic_calls);
+    }
+    if (stats_state->calls != 0) {
+        stats.mean_execution_time = chrono::microseconds(stats_state->total_execution_us / stats_state->calls);
+    }
+    return stats;
+}
+
+void ESPTimer::reset_stats()
+{
+    if (!stats_state) {
+        throw ESPException(ESP_ERR_INVALID_STATE);
+    }
+
+    lock_guard<mutex> lock(stats_state->mutex);
+    stats_state->calls = 0;
+    stats_state->periodic_calls = 0;
+    stats_state->missed_periods = 0;
+    stats_state->max_lateness_us = 0;
+    stats_state->total_lateness_us = 0;
+    stats_state->max_execution_us = 0;
+    stats_state->total_execution_us = 0;
+}
+
+void ESPTimer::stats_on_start(int64_t expected_us, int64_t period_us) noexcept
+{
+    lock_guard<mutex> lock(stats_state->mutex);
+    stats_state->expected_us = expected_us;
+    stats_state->period_us = period_us;
+}
+
+void ESPTimer::stats_on_restart(int64_t timeout_us) noexcept
+{
+    lock_guard<mutex> lock(stats_state->mutex);
+    // A restarted periodic timer gets the timeout as new period, a one-shot timer stays one-shot
+    if (stats_state->period_us != 0) {
+        stats_state->expected_us = esp_timer_get_time() + timeout_us;
+        stats_state->period_us = timeout_us;
+    }
+}
+
+void ESPTimer::call_with_stats()
+{
+    const int64_t start_us = esp_timer_get_time();
+    {
+        lock_guard<mutex> lock(stats_state->mutex);
+        const int64_t period_us = stats_state->period_us;
+        if (period_us > 0) {
+            const int64_t late_us = max<int64_t>(start_us - stats_state->expected_us, 0);
+            stats_state->periodic_calls++;
+            stats_state->total_lateness_us += late_us;
+            stats_state->max_lateness_us = max(stats_state->max_lateness_us, late_us);
+            if (late_us >= period_us) {
+                stats_state->missed_periods++;
+            }
+
+            // Without skip_unhandled_events, esp_timer calls the callback once per period, late or not. With it,
+            // esp_timer moves the next alarm to the first period still in the future, skipping all the periods
+            // already due: alarm += period * (late / period + 1).
+            int64_t skipped = 0;
+            if (skip_unhandled_events) {
+                skipped = late_us / period_us;
+            }
+            stats_state->missed_periods += static_cast<uint32_t>(skipped);
+            stats_state->expected_us += (skipped + 1) * period_us;
+        }
+    }
+
+    if (inline_invoke != nullptr) {
+        inline_invoke(inline_callback);
+    } else {
+        timeout_cb();
+    }
+
+    const int64_t execution_us = esp_timer_get_time() - start_us;
+    lock_guard<mutex> lock(stats_state->mutex);
+    stats_state->calls++;
+    stats_state->total_execution_us += execution_us;
+    stats_state->max_execution_us = max(stats_state->max_execution_us, execution_us);
 }
 
 void ESPTimer::esp_timer_cb(void *arg)
 {
     ESPTimer *timer = static_cast<ESPTimer*>(arg);
-    timer->timeout_cb();
+    if (timer->stats_state) {
+        timer->call_with_stats();
+    } else if (timer->inline_invoke != nullptr) {
+        timer->inline_invoke(timer->inline_callback);
+    } else {
+        timer->timeout_cb();
+    }
+}
+
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+void IRAM_ATTR ESPTimer::esp_timer_isr_cb(void *arg)
+{
+    ESPTimer *timer = static_cast<ESPTimer*>(arg);
+    if (timer->isr_cb(timer->isr_arg)) {
+        esp_timer_isr_dispatch_need_yield();
+    }
 }
+#endif
 
 } // esp_timer
 
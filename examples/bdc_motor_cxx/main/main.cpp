@@ -17,7 +17,7 @@
 extern "C" void app_main(void)
 {
     try {
-        idf::BdcMotor motor(idf::GPIONum(25), idf::GPIONum(26), 25000, 0, 10000000);
+        idf::BdcMotor motor(idf::GPIONum::make<25>(), idf::GPIONum::make<26>(), 25000, 0, 10000000);
         motor.enable();
         motor.setPower(100);
 
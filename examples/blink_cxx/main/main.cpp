@@ -20,9 +20,9 @@ extern "C" void app_main(void)
     /* The functions of GPIO_Output throws exceptions in case of parameter errors or if there are underlying driver
        errors. */
     try {
-        /* This line may throw an exception if the pin number is invalid.
+        /* The pin number is checked at compile time, this line may only throw an exception if the driver fails.
          * Alternatively to 4, choose another output-capable pin. */
-        const GPIO_Output gpio(GPIONum(4));
+        const GPIO_Output gpio(GPIONum::make<4>());
 
         while (true) {
             printf("LED ON\n");
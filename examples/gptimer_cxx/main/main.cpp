@@ -18,7 +18,7 @@ extern "C" void app_main(void)
     try {
         idf::GpTimer timer(GPTIMER_COUNT_UP, 1000000u); // Set Frequency at 1Mhz => 1 unit is 1us
         timer.setAlarmAction(100000u, 0u); // Set period at 100ms
-        idf::GPIO_Output ledGpio(idf::GPIONum(26));
+        idf::GPIO_Output ledGpio(idf::GPIONum::make<26>());
         bool ledState = false;
         timer.registerEventCallbacks([&ledState, &ledGpio](const idf::GpTimer &, const gptimer_alarm_event_data_t &){
             ledState = !ledState;
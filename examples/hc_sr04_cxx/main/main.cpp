@@ -14,7 +14,7 @@
 #include "esp_private/esp_clk.h"
 #include "gpio_cxx.hpp"
 #include "mcpwm_cxx.hpp"
-#include "queue_cxx.hpp"
+#include "spsc_ring_cxx.hpp"
 #include <thread>
 #include <utility>
 
@@ -30,7 +30,7 @@ public:
         : _trigGpio(idf::GPIONum(trigGpio))
         , _capTimer(0)
         , _capChannel{_capTimer, echoGpio, 1, true, true, false, false, false, false, false}
-        , _rspQueue(10u)
+        , _rspRing()
         , _lastCapValue(0u, 0u)
     {
         _capChannel.registerEventCallbacks([this](const idf::mcpwm::CaptureChannel &, const mcpwm_capture_event_data_t & eventData){
@@ -71,7 +71,7 @@ public:
 
     std::optional<float> receive(TickType_t ticksToWait)
     {
-        auto rsp = _rspQueue.receive(ticksToWait);
+        auto rsp = _rspRing.pop(ticksToWait);
         if (rsp.has_value()) {
             float pulseWidthUs = rsp.value() * (1000000.0 / _capTimer.getResolution());
             // if not out of range
@@ -87,7 +87,7 @@ private:
         bool highTaskWakeup = false;
 
         //calculate the interval in the ISR,
-        //so that the interval will be always correct even when capture_queue is not handled in time and overflow.
+        //so that the interval will be always correct even when the ring is not handled in time and overflow.
         if (eventData.cap_edge == MCPWM_CAP_EDGE_POS) {
             // store the timestamp when pos edge is detected
             _lastCapValue.first = eventData.cap_value;
@@ -97,7 +97,7 @@ private:
             uint32_t tofTicks = _lastCapValue.second - _lastCapValue.first;
 
             // notify the task to calculate the distance
-            _rspQueue.sendFromISR(tofTicks, highTaskWakeup);
+            _rspRing.pushFromISR(tofTicks, highTaskWakeup);
         }
 
         return highTaskWakeup;
@@ -109,14 +109,14 @@ private:
     idf::GPIO_Output _trigGpio;
     idf::mcpwm::CaptureTimer _capTimer;
     idf::mcpwm::CaptureChannel _capChannel;
-    idf::Queue<uint32_t> _rspQueue;
+    idf::SpscRing<uint32_t, 16> _rspRing;
     std::pair<uint32_t,uint32_t> _lastCapValue;
 };
 
 extern "C" void app_main(void)
 {
     try {
-        HcSr04 hcSr04(idf::GPIONum(HC_SR04_TRIG_GPIO), idf::GPIONum(HC_SR04_ECHO_GPIO));
+        HcSr04 hcSr04(idf::GPIONum::make<HC_SR04_TRIG_GPIO>(), idf::GPIONum::make<HC_SR04_ECHO_GPIO>());
         hcSr04.enable();
         hcSr04.start();
 
@@ -24,7 +24,7 @@ extern "C" void app_main(void)
     {
         ESP_LOGI(TAG, "Configure LED controleur");
         idf::LedcTimer ledcTimer0(LEDC_TIMER_0, 440, LEDC_LOW_SPEED_MODE, LEDC_TIMER_13_BIT);
-        idf::LedcChannel ledcChannel0(LEDC_CHANNEL_0, ledcTimer0, idf::GPIONum(16), 1<<12);
+        idf::LedcChannel ledcChannel0(LEDC_CHANNEL_0, ledcTimer0, idf::GPIONum::make<16>(), 1<<12);
 
         // play 440 Hz for 1s
         ESP_LOGI(TAG, "Play a 440Hz sound for 1s");
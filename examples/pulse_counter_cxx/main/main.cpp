@@ -19,7 +19,7 @@ extern "C" void app_main(void)
         idf::PulseCounter pulseCounter(-10, 10, true);
         pulseCounter.addWatchPoints(-10);
         pulseCounter.addWatchPoints(10);
-        idf::PulseCounter::Channel channel(pulseCounter, idf::GPIONum(25), {});
+        idf::PulseCounter::Channel channel(pulseCounter, idf::GPIONum::make<25>(), {});
         channel.setEdgeChannelAction(PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_HOLD);
         pulseCounter.registerEventCallbacks([&pulseCounterQueue](const idf::PulseCounter & pulseCounter, const pcnt_watch_event_data_t &){
             bool higherPriorityTaskWoken;
@@ -7,6 +7,7 @@
 #if __cpp_exceptions
 
 #include <array>
+#include <cassert>
 #include "driver/gpio.h"
 #include "gpio_cxx.hpp"
 
@@ -14,40 +15,18 @@ namespace idf {
 
 #define GPIO_CHECK_THROW(err) CHECK_THROW_SPECIFIC((err), GPIOException)
 
-namespace {
 #if CONFIG_IDF_TARGET_LINUX
-constexpr std::array<uint32_t, 1> INVALID_GPIOS = {24};
-#elif CONFIG_IDF_TARGET_ESP32
-constexpr std::array<uint32_t, 1> INVALID_GPIOS = {24};
-#elif CONFIG_IDF_TARGET_ESP32S2
-constexpr std::array<uint32_t, 4> INVALID_GPIOS = {22, 23, 24, 25};
-#elif CONFIG_IDF_TARGET_ESP32S3
-constexpr std::array<uint32_t, 4> INVALID_GPIOS = {22, 23, 24, 25};
-#elif CONFIG_IDF_TARGET_ESP32C3
-constexpr std::array<uint32_t, 0> INVALID_GPIOS = {};
-#elif CONFIG_IDF_TARGET_ESP32C2
-constexpr std::array<uint32_t, 0> INVALID_GPIOS = {};
-#else
-#error "No GPIOs defined for the current target"
+gpio_reg::SimulatedRegisters gpio_reg::simulated_registers = {};
 #endif
 
-}
-
 GPIOException::GPIOException(esp_err_t error) : ESPException(error) { }
 
 esp_err_t check_gpio_pin_num(uint32_t pin_num) noexcept
 {
-    if (pin_num >= GPIO_NUM_MAX) {
+    if (!is_valid_gpio_pin_num(pin_num)) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    for (auto num: INVALID_GPIOS)
-    {
-        if (pin_num == num) {
-            return ESP_ERR_INVALID_ARG;
-        }
-    }
-
     return ESP_OK;
 }
 
@@ -60,6 +39,17 @@ esp_err_t check_gpio_drive_strength(uint32_t strength) noexcept
     return ESP_OK;
 }
 
+void configure_gpio_outputs(uint64_t pin_bit_mask)
+{
+    gpio_config_t config = {};
+    config.pin_bit_mask = pin_bit_mask;
+    config.mode = GPIO_MODE_OUTPUT;
+    config.pull_up_en = GPIO_PULLUP_DISABLE;
+    config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    config.intr_type = GPIO_INTR_DISABLE;
+    GPIO_CHECK_THROW(gpio_config(&config));
+}
+
 GPIOPullMode GPIOPullMode::FLOATING()
 {
     return GPIOPullMode(GPIO_FLOATING);
@@ -75,6 +65,11 @@ GPIOPullMode GPIOPullMode::PULLDOWN()
     return GPIOPullMode(GPIO_PULLDOWN_ONLY);
 }
 
+GPIOPullMode GPIOPullMode::PULLUP_PULLDOWN()
+{
+    return GPIOPullMode(GPIO_PULLUP_PULLDOWN);
+}
+
 GPIOWakeupIntrType GPIOWakeupIntrType::LOW_LEVEL()
 {
     return GPIOWakeupIntrType(GPIO_INTR_LOW_LEVEL);
@@ -115,6 +110,8 @@ GPIOBase::GPIOBase(GPIONum num) : gpio_num(num)
     GPIO_CHECK_THROW(gpio_reset_pin(gpio_num.get_value<gpio_num_t>()));
 }
 
+GPIOBase::GPIOBase(GPIONum num, GPIOConfigured) noexcept : gpio_num(num) { }
+
 void GPIOBase::hold_en()
 {
     GPIO_CHECK_THROW(gpio_hold_en(gpio_num.get_value<gpio_num_t>()));
@@ -131,11 +128,14 @@ void GPIOBase::set_drive_strength(GPIODriveStrength strength)
                                                strength.get_value<gpio_drive_cap_t>()));
 }
 
-GPIO_Output::GPIO_Output(GPIONum num) : GPIOBase(num)
+GPIO_Output::GPIO_Output(GPIONum num) : GPIOBase(num), pin_mask(gpio_reg::pin_mask(num.get_value()))
 {
     GPIO_CHECK_THROW(gpio_set_direction(gpio_num.get_value<gpio_num_t>(), GPIO_MODE_OUTPUT));
 }
 
+GPIO_Output::GPIO_Output(GPIONum num, GPIOConfigured configured) noexcept
+    : GPIOBase(num, configured), pin_mask(gpio_reg::pin_mask(num.get_value())) { }
+
 void GPIO_Output::set_high() const
 {
     GPIO_CHECK_THROW(gpio_set_level(gpio_num.get_value<gpio_num_t>(), 1));
@@ -153,38 +153,131 @@ GPIODriveStrength GPIOBase::get_drive_strength()
     return GPIODriveStrength(static_cast<uint32_t>(strength));
 }
 
+std::atomic<uint32_t> GPIOISRService::_users(0u);
+std::mutex GPIOISRService::_mutex;
+int GPIOISRService::_flags = 0;
+bool GPIOISRService::_installed = false;
+bool GPIOISRService::_owned = false;
+
+void GPIOISRService::set_flags(int intr_alloc_flags)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_installed && intr_alloc_flags != _flags)
+        throw GPIOException(ESP_ERR_INVALID_STATE);
+    _flags = intr_alloc_flags;
+}
+
+int GPIOISRService::get_flags() noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _flags;
+}
+
+void GPIOISRService::acquire()
+{
+    // Fast path: the service is installed and stays installed as long as the count is not 0
+    uint32_t users = _users.load(std::memory_order_acquire);
+    while (users != 0u) {
+        if (_users.compare_exchange_weak(users, users + 1u, std::memory_order_acq_rel))
+            return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_installed) {
+        esp_err_t result = gpio_install_isr_service(_flags);
+        // ESP_ERR_INVALID_STATE: already installed by other code, use it without owning it
+        if (result != ESP_OK && result != ESP_ERR_INVALID_STATE)
+            throw GPIOException(result);
+        _installed = true;
+        _owned = (result == ESP_OK);
+    }
+    _users.fetch_add(1u, std::memory_order_acq_rel);
+}
+
+void GPIOISRService::release() noexcept
+{
+    // Fast path: not the last user
+    uint32_t users = _users.load(std::memory_order_acquire);
+    while (users > 1u) {
+        if (_users.compare_exchange_weak(users, users - 1u, std::memory_order_acq_rel))
+            return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    // A concurrent acquire() may have added a user since the fast path
+    if (_users.fetch_sub(1u, std::memory_order_acq_rel) == 1u) {
+        if (_owned)
+            gpio_uninstall_isr_service();
+        _installed = false;
+        _owned = false;
+    }
+}
+
+uint32_t GPIOISRService::get_user_count() noexcept
+{
+    return _users.load(std::memory_order_acquire);
+}
+
 GPIOInput::GPIOInput(GPIONum num, gpio_int_type_t intType, const CallBack & callback)
     : GPIOBase(num)
     , _callback()
+    , _isr_handler_added(false)
 {
     GPIO_CHECK_THROW(gpio_set_direction(gpio_num.get_value<gpio_num_t>(), GPIO_MODE_INPUT));
-    GPIO_CHECK_THROW(gpio_set_intr_type(gpio_num.get_value<gpio_num_t>(), intType));
-    if (intType != GPIO_INTR_DISABLE)
-    {
-        if (!callback)
-            throw idf::ESPException(ESP_ERR_INVALID_ARG);
-        if (_isrHandlerCount == 0)
-            GPIO_CHECK_THROW(gpio_install_isr_service(0));
-        _isrHandlerCount++;
-        _callback = callback;
-        GPIO_CHECK_THROW(gpio_isr_handler_add(gpio_num.get_value<gpio_num_t>(), [](void * userCtx){
-            const GPIOInput * gpioInput = reinterpret_cast<const GPIOInput *>(userCtx);
-            return gpioInput->_callback();
-        }, this));
+    if (intType == GPIO_INTR_DISABLE) {
+        GPIO_CHECK_THROW(gpio_set_intr_type(gpio_num.get_value<gpio_num_t>(), intType));
+        return;
     }
+    if (!callback)
+        throw idf::ESPException(ESP_ERR_INVALID_ARG);
+    _callback = callback;
+    add_isr_handler(intType, &callback_trampoline, this);
+}
+
+GPIOInput::GPIOInput(GPIONum num, GPIOConfigured configured) noexcept
+    : GPIOBase(num, configured)
+    , _callback()
+    , _isr_handler_added(false)
+{
 }
 
 GPIOInput::~GPIOInput()
 {
-    if (_callback)
+    if (_isr_handler_added)
     {
-        assert(gpio_isr_handler_remove(gpio_num.get_value<gpio_num_t>()) == ESP_OK);
-        _isrHandlerCount--;
-        if (_isrHandlerCount == 0)
-            gpio_uninstall_isr_service();
+        [[maybe_unused]] esp_err_t ret = gpio_isr_handler_remove(gpio_num.get_value<gpio_num_t>());
+        assert(ret == ESP_OK);
+        GPIOISRService::release();
     }
 }
 
+void GPIOInput::callback_trampoline(void *arg)
+{
+    const GPIOInput * gpioInput = reinterpret_cast<const GPIOInput *>(arg);
+    gpioInput->_callback();
+}
+
+void GPIOInput::add_isr_handler(gpio_int_type_t intType, ISRHandler handler, void *arg)
+{
+    if (_isr_handler_added)
+        throw GPIOException(ESP_ERR_INVALID_STATE);
+    if (intType == GPIO_INTR_DISABLE)
+        throw GPIOException(ESP_ERR_INVALID_ARG);
+    // Acquire the service first, so that the interrupt is never enabled without a handler if it can't be installed
+    GPIOISRService::acquire();
+    esp_err_t result = gpio_set_intr_type(gpio_num.get_value<gpio_num_t>(), intType);
+    if (result == ESP_OK) {
+        result = gpio_isr_handler_add(gpio_num.get_value<gpio_num_t>(), handler, arg);
+        if (result != ESP_OK)
+            gpio_set_intr_type(gpio_num.get_value<gpio_num_t>(), GPIO_INTR_DISABLE);
+    }
+    if (result != ESP_OK) {
+        GPIOISRService::release();
+        throw GPIOException(result);
+    }
+    _isr_handler_added = true;
+}
+
 bool GPIOInput::get_level() const noexcept
 {
     static_assert(static_cast<bool>(1) == true);
@@ -209,13 +302,13 @@ void GPIOInput::wakeup_disable() const
     GPIO_CHECK_THROW(gpio_wakeup_disable(gpio_num.get_value<gpio_num_t>()));
 }
 
-int GPIOInput::_isrHandlerCount = 0;
-
 GPIO_OpenDrain::GPIO_OpenDrain(GPIONum num) : GPIOInput(num)
 {
     GPIO_CHECK_THROW(gpio_set_direction(gpio_num.get_value<gpio_num_t>(), GPIO_MODE_INPUT_OUTPUT_OD));
 }
 
+GPIO_OpenDrain::GPIO_OpenDrain(GPIONum num, GPIOConfigured configured) noexcept : GPIOInput(num, configured) { }
+
 void GPIO_OpenDrain::set_floating() const
 {
     GPIO_CHECK_THROW(gpio_set_level(gpio_num.get_value<gpio_num_t>(), 1));
@@ -226,6 +319,97 @@ void GPIO_OpenDrain::set_low() const
     GPIO_CHECK_THROW(gpio_set_level(gpio_num.get_value<gpio_num_t>(), 0));
 }
 
+
+GPIOConfigBatch::GPIOConfigBatch() : _groups(), _pin_bit_mask(0u), _applied(false) { }
+
+GPIOConfigBatch & GPIOConfigBatch::add_output(GPIONum num)
+{
+    add(num, GPIO_MODE_OUTPUT, GPIO_FLOATING, GPIO_INTR_DISABLE);
+    return *this;
+}
+
+GPIOConfigBatch & GPIOConfigBatch::add_input(GPIONum num, GPIOPullMode pull_mode, gpio_int_type_t intType)
+{
+    add(num, GPIO_MODE_INPUT, pull_mode.get_value<gpio_pull_mode_t>(), intType);
+    return *this;
+}
+
+GPIOConfigBatch & GPIOConfigBatch::add_open_drain(GPIONum num)
+{
+    add(num, GPIO_MODE_INPUT_OUTPUT_OD, GPIO_FLOATING, GPIO_INTR_DISABLE);
+    return *this;
+}
+
+void GPIOConfigBatch::add(GPIONum num, gpio_mode_t mode, gpio_pull_mode_t pull_mode, gpio_int_type_t intr_type)
+{
+    if (_applied)
+        throw GPIOException(ESP_ERR_INVALID_STATE);
+    const uint64_t pin_bit = 1ull << num.get_value();
+    if ((_pin_bit_mask & pin_bit) != 0u)
+        throw GPIOException(ESP_ERR_INVALID_ARG);
+
+    for (Group & group : _groups) {
+        if (group.mode == mode && group.pull_mode == pull_mode && group.intr_type == intr_type) {
+            group.pin_bit_mask |= pin_bit;
+            _pin_bit_mask |= pin_bit;
+            return;
+        }
+    }
+    _groups.push_back(Group{mode, pull_mode, intr_type, pin_bit});
+    _pin_bit_mask |= pin_bit;
+}
+
+void GPIOConfigBatch::apply()
+{
+    if (_applied)
+        throw GPIOException(ESP_ERR_INVALID_STATE);
+    for (const Group & group : _groups) {
+        gpio_config_t config = {};
+        config.pin_bit_mask = group.pin_bit_mask;
+        config.mode = group.mode;
+        config.pull_up_en = (group.pull_mode == GPIO_PULLUP_ONLY || group.pull_mode == GPIO_PULLUP_PULLDOWN)
+                ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE;
+        config.pull_down_en = (group.pull_mode == GPIO_PULLDOWN_ONLY || group.pull_mode == GPIO_PULLUP_PULLDOWN)
+                ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE;
+        config.intr_type = group.intr_type;
+        GPIO_CHECK_THROW(gpio_config(&config));
+    }
+    _applied = true;
+}
+
+GPIO_Output GPIOConfigBatch::output(GPIONum num) const
+{
+    check_added(num, GPIO_MODE_OUTPUT);
+    return GPIO_Output(num, GPIOConfigured());
+}
+
+GPIOInput GPIOConfigBatch::input(GPIONum num) const
+{
+    check_added(num, GPIO_MODE_INPUT);
+    return GPIOInput(num, GPIOConfigured());
+}
+
+GPIO_OpenDrain GPIOConfigBatch::open_drain(GPIONum num) const
+{
+    check_added(num, GPIO_MODE_INPUT_OUTPUT_OD);
+    return GPIO_OpenDrain(num, GPIOConfigured());
+}
+
+void GPIOConfigBatch::check_added(GPIONum num, gpio_mode_t mode) const
+{
+    if (!_applied)
+        throw GPIOException(ESP_ERR_INVALID_STATE);
+    const uint64_t pin_bit = 1ull << num.get_value();
+    for (const Group & group : _groups) {
+        if ((group.pin_bit_mask & pin_bit) != 0u) {
+            if (group.mode != mode)
+                break;
+            return;
+        }
+    }
+    throw GPIOException(ESP_ERR_INVALID_ARG);
+}
+
 }
 
 #endif
@@ -0,0 +1,81 @@
+#if __cpp_exceptions
+
+#include "driver/gpio.h"
+#include "gpio_debounce_cxx.hpp"
+
+namespace idf {
+
+#define GPIO_CHECK_THROW(err) CHECK_THROW_SPECIFIC((err), GPIOException)
+
+GPIODebounceGroup::GPIODebounceGroup(std::span<const GPIONum> pins,
+        CallBack callback,
+        std::chrono::microseconds sample_period,
+        GPIOPullMode pull_mode)
+    : _callback(callback)
+    , _banks()
+    , _timer([this]() { sample(); }, esp_timer::StaticName("GPIODebounce"))
+{
+    if (!_callback)
+        throw GPIOException(ESP_ERR_INVALID_ARG);
+
+    uint64_t pin_bit_mask = 0u;
+    for (const GPIONum & pin : pins) {
+        const gpio_reg::PinMask pin_mask = gpio_reg::pin_mask(pin.get_value());
+        if ((_banks[pin_mask.bank].mask & pin_mask.mask) != 0u)
+            throw GPIOException(ESP_ERR_INVALID_ARG);
+        _banks[pin_mask.bank].mask |= pin_mask.mask;
+        pin_bit_mask |= 1ull << pin.get_value();
+    }
+
+    gpio_config_t config = {};
+    config.pin_bit_mask = pin_bit_mask;
+    config.mode = GPIO_MODE_INPUT;
+    config.pull_up_en = (pull_mode == GPIOPullMode::PULLUP() || pull_mode == GPIOPullMode::PULLUP_PULLDOWN())
+            ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE;
+    config.pull_down_en = (pull_mode == GPIOPullMode::PULLDOWN() || pull_mode == GPIOPullMode::PULLUP_PULLDOWN())
+            ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE;
+    config.intr_type = GPIO_INTR_DISABLE;
+    GPIO_CHECK_THROW(gpio_config(&config));
+
+    for (uint32_t bank = 0u; bank < _banks.size(); bank++)
+        _banks[bank].level.store(gpio_reg::read_input(bank) & _banks[bank].mask, std::memory_order_relaxed);
+
+    _timer.start_periodic(sample_period);
+}
+
+bool GPIODebounceGroup::get_level(GPIONum num) const noexcept
+{
+    const gpio_reg::PinMask pin_mask = gpio_reg::pin_mask(num.get_value());
+    return (_banks[pin_mask.bank].level.load(std::memory_order_relaxed) & pin_mask.mask) != 0u;
+}
+
+void GPIODebounceGroup::sample()
+{
+    for (uint32_t bank_index = 0u; bank_index < _banks.size(); bank_index++) {
+        Bank & bank = _banks[bank_index];
+        if (bank.mask == 0u)
+            continue;
+
+        const uint32_t level = bank.level.load(std::memory_order_relaxed);
+        // Pins whose sample differs from the debounced level
+        const uint32_t delta = (gpio_reg::read_input(bank_index) & bank.mask) ^ level;
+        // Pins which had already differed for SAMPLE_COUNT - 1 samples, their counter wraps to 0
+        const uint32_t toggle = delta & bank.count0 & bank.count1;
+        // Increment the counters of the differing pins, reset the others
+        bank.count1 = (bank.count1 ^ bank.count0) & delta;
+        bank.count0 = ~bank.count0 & delta;
+
+        if (toggle == 0u)
+            continue;
+        const uint32_t new_level = level ^ toggle;
+        bank.level.store(new_level, std::memory_order_relaxed);
+        for (uint32_t changed = toggle; changed != 0u; changed &= changed - 1u) {
+            const uint32_t bit = __builtin_ctz(changed);
+            _callback(GPIONum(bank_index * 32u + bit), (new_level >> bit) & 1u);
+        }
+    }
+}
+
+} // idf
+
+#endif
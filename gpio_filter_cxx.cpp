@@ -0,0 +1,105 @@
+#if __cpp_exceptions
+
+#include "gpio_filter_cxx.hpp"
+
+#if GPIO_GLITCH_FILTER_CXX_SUPPORTED
+
+#include <cassert>
+
+namespace idf {
+
+#define GPIO_CHECK_THROW(err) CHECK_THROW_SPECIFIC((err), GPIOException)
+
+namespace {
+
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+gpio_glitch_filter_handle_t new_pin_filter(const GPIOInput & input)
+{
+    gpio_pin_glitch_filter_config_t config = {};
+    config.clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT;
+    config.gpio_num = input.get_num().get_value<gpio_num_t>();
+    gpio_glitch_filter_handle_t handle = nullptr;
+    GPIO_CHECK_THROW(gpio_new_pin_glitch_filter(&config, &handle));
+    return handle;
+}
+#endif
+
+#if SOC_GPIO_FLEX_GLITCH_FILTER_NUM > 0
+gpio_glitch_filter_handle_t new_flex_filter(const GPIOInput & input,
+        std::chrono::nanoseconds window_width,
+        std::chrono::nanoseconds window_threshold)
+{
+    if (window_threshold > window_width || window_threshold.count() <= 0)
+        throw GPIOException(ESP_ERR_INVALID_ARG);
+    gpio_flex_glitch_filter_config_t config = {};
+    config.clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT;
+    config.gpio_num = input.get_num().get_value<gpio_num_t>();
+    config.window_width_ns = static_cast<uint32_t>(window_width.count());
+    config.window_thres_ns = static_cast<uint32_t>(window_threshold.count());
+    gpio_glitch_filter_handle_t handle = nullptr;
+    GPIO_CHECK_THROW(gpio_new_flex_glitch_filter(&config, &handle));
+    return handle;
+}
+#endif
+
+} // namespace
+
+GPIOGlitchFilter::GPIOGlitchFilter(gpio_glitch_filter_handle_t handle)
+    : _handle(handle)
+    , _enabled(false)
+{
+    esp_err_t result = gpio_glitch_filter_enable(_handle);
+    if (result != ESP_OK) {
+        gpio_del_glitch_filter(_handle);
+        throw GPIOException(result);
+    }
+    _enabled = true;
+}
+
+GPIOGlitchFilter::~GPIOGlitchFilter()
+{
+    // Ignore potential error return code to not throw exception.
+    if (_enabled)
+        gpio_glitch_filter_disable(_handle);
+    [[maybe_unused]] esp_err_t ret = gpio_del_glitch_filter(_handle);
+    assert(ret == ESP_OK);
+}
+
+void GPIOGlitchFilter::enable()
+{
+    GPIO_CHECK_THROW(gpio_glitch_filter_enable(_handle));
+    _enabled = true;
+}
+
+void GPIOGlitchFilter::disable()
+{
+    GPIO_CHECK_THROW(gpio_glitch_filter_disable(_handle));
+    _enabled = false;
+}
+
+bool GPIOGlitchFilter::is_enabled() const noexcept
+{
+    return _enabled;
+}
+
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+GPIOPinGlitchFilter::GPIOPinGlitchFilter(const GPIOInput & input)
+    : GPIOGlitchFilter(new_pin_filter(input))
+{
+}
+#endif
+
+#if SOC_GPIO_FLEX_GLITCH_FILTER_NUM > 0
+GPIOFlexGlitchFilter::GPIOFlexGlitchFilter(const GPIOInput & input,
+        std::chrono::nanoseconds window_width,
+        std::chrono::nanoseconds window_threshold)
+    : GPIOGlitchFilter(new_flex_filter(input, window_width, window_threshold))
+{
+}
+#endif
+
+} // idf
+
+#endif // GPIO_GLITCH_FILTER_CXX_SUPPORTED
+
+#endif
@@ -0,0 +1,906 @@
+/*
+ * ESPEventLoop C++ unit tests on the host event loop
+ *
+ * SPDX-License-Identifier: CC0
+ *
+ * This test code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#define CATCH_CONFIG_MAIN
+
+#include <stdio.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include "esp_event_cxx.hpp"
+#include "esp_event_api.hpp"
+#include "local_bus_cxx.hpp"
+
+#include "catch.hpp"
+
+// TODO: IDF-2693, function definition just to satisfy linker, mock esp_common instead
+const char *esp_err_to_name(esp_err_t code) {
+    return "test";
+}
+
+using namespace std;
+using namespace idf::event;
+
+ESP_EVENT_DEFINE_BASE(TEST_EVENT_BASE_0);
+ESP_EVENT_DEFINE_BASE(TEST_EVENT_BASE_1);
+
+static const ESPEvent TEST_EVENT_0(TEST_EVENT_BASE_0, ESPEventID(0));
+static const ESPEvent TEST_EVENT_1(TEST_EVENT_BASE_0, ESPEventID(1));
+static const ESPEvent TEST_EVENT_OTHER_BASE(TEST_EVENT_BASE_1, ESPEventID(0));
+
+/**
+ * Counts the handler calls and lets the test thread wait for them.
+ */
+struct CallCounter {
+    void increment()
+    {
+        {
+            lock_guard<mutex> lock(counter_mutex);
+            count++;
+        }
+        counted.notify_all();
+    }
+
+    bool wait_for(size_t expected, chrono::milliseconds timeout = chrono::milliseconds(1000))
+    {
+        unique_lock<mutex> lock(counter_mutex);
+        return counted.wait_for(lock, timeout, [&]() { return count >= expected; });
+    }
+
+    size_t get()
+    {
+        lock_guard<mutex> lock(counter_mutex);
+        return count;
+    }
+
+    mutex counter_mutex;
+    condition_variable counted;
+    size_t count = 0;
+};
+
+TEST_CASE("ESPEventAPIHost zero queue size")
+{
+    CHECK_THROWS_AS(ESPEventAPIHost(0), EventException&);
+}
+
+TEST_CASE("ESPEventAPIHost rejects a specific ID of any base")
+{
+    ESPEventAPIHost api;
+    esp_event_handler_instance_t instance;
+
+    CHECK(api.handler_register(ESP_EVENT_ANY_BASE, 0, [](void*, esp_event_base_t, int32_t, void*) { }, nullptr,
+            &instance) == ESP_ERR_INVALID_ARG);
+}
+
+TEST_CASE("ESPEventLoop dispatches a copy of the event data")
+{
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>());
+    CallCounter counter;
+    int received = 0;
+
+    auto reg = loop.register_event(TEST_EVENT_0, [&](const ESPEvent &event, void *data) {
+        CHECK(event == TEST_EVENT_0);
+        received = *static_cast<int*>(data);
+        counter.increment();
+    });
+
+    int data = 47;
+    loop.post_event_data(TEST_EVENT_0, data);
+    data = 0;
+
+    REQUIRE(counter.wait_for(1));
+    CHECK(received == 47);
+}
+
+TEST_CASE("ESPEventLoop dispatches events without data")
+{
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>());
+    CallCounter counter;
+    void *received = &counter;
+
+    auto reg = loop.register_event(TEST_EVENT_0, [&](const ESPEvent &event, void *data) {
+        received = data;
+        counter.increment();
+    });
+
+    loop.post_event_data(TEST_EVENT_0);
+
+    REQUIRE(counter.wait_for(1));
+    CHECK(received == nullptr);
+}
+
+TEST_CASE("ESPEventLoop handler of any ID only receives its base")
+{
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>());
+    CallCounter any_id;
+    CallCounter last;
+
+    auto reg_any = loop.register_event(ESPEvent(TEST_EVENT_BASE_0, ESPEventID(ESP_EVENT_ANY_ID)),
+            [&](const ESPEvent &event, void *data) { any_id.increment(); });
+    auto reg_last = loop.register_event(TEST_EVENT_OTHER_BASE,
+            [&](const ESPEvent &event, void *data) { last.increment(); });
+
+    loop.post_event_data(TEST_EVENT_0);
+    loop.post_event_data(TEST_EVENT_1);
+    loop.post_event_data(TEST_EVENT_OTHER_BASE);
+
+    // Events are dispatched in order, so the first two are done after the last one
+    REQUIRE(last.wait_for(1));
+    CHECK(any_id.get() == 2);
+}
+
+TEST_CASE("ESPEventLoop unregisters in ESPEventReg destructor")
+{
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>());
+    CallCounter removed;
+    CallCounter kept;
+
+    auto reg_kept = loop.register_event(TEST_EVENT_0, [&](const ESPEvent &event, void *data) { kept.increment(); });
+    auto reg_removed = loop.register_event(TEST_EVENT_0,
+            [&](const ESPEvent &event, void *data) { removed.increment(); });
+    reg_removed.reset();
+
+    loop.post_event_data(TEST_EVENT_0);
+
+    REQUIRE(kept.wait_for(1));
+    CHECK(removed.get() == 0);
+}
+
+struct SelfUnregistering {
+    ESPEventAPIHost &api;
+    esp_event_handler_instance_t instance;
+    CallCounter counter;
+};
+
+static void self_unregistering_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    SelfUnregistering *handler = static_cast<SelfUnregistering*>(arg);
+    CHECK(handler->api.handler_unregister(base, id, handler->instance) == ESP_OK);
+    handler->counter.increment();
+}
+
+static void counting_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    static_cast<CallCounter*>(arg)->increment();
+}
+
+TEST_CASE("ESPEventAPIHost handler can unregister itself")
+{
+    ESPEventAPIHost api;
+    SelfUnregistering self{api, nullptr, {}};
+    CallCounter next;
+    esp_event_handler_instance_t next_instance;
+
+    REQUIRE(api.handler_register(TEST_EVENT_BASE_0, 0, self_unregistering_handler, &self, &self.instance) == ESP_OK);
+    REQUIRE(api.handler_register(TEST_EVENT_BASE_0, 0, counting_handler, &next, &next_instance) == ESP_OK);
+
+    CHECK(api.post(TEST_EVENT_BASE_0, 0, nullptr, 0, portMAX_DELAY) == ESP_OK);
+    CHECK(api.post(TEST_EVENT_BASE_0, 0, nullptr, 0, portMAX_DELAY) == ESP_OK);
+
+    REQUIRE(next.wait_for(2));
+    CHECK(self.counter.get() == 1);
+    CHECK(api.handler_unregister(TEST_EVENT_BASE_0, 0, self.instance) == ESP_ERR_INVALID_ARG);
+}
+
+struct Registering {
+    ESPEventAPIHost &api;
+    CallCounter &added;
+    esp_event_handler_instance_t added_instance;
+};
+
+static void registering_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    Registering *handler = static_cast<Registering*>(arg);
+    if (handler->added_instance == nullptr) {
+        CHECK(handler->api.handler_register(base, id, counting_handler, &handler->added, &handler->added_instance)
+                == ESP_OK);
+    }
+}
+
+TEST_CASE("ESPEventAPIHost handler registered during a dispatch is called from the next event")
+{
+    // The counters are declared first, so that the loop thread is stopped before they are destroyed
+    CallCounter added;
+    CallCounter done;
+    ESPEventAPIHost api;
+    Registering registering{api, added, nullptr};
+    esp_event_handler_instance_t registering_instance;
+    esp_event_handler_instance_t done_instance;
+
+    REQUIRE(api.handler_register(TEST_EVENT_BASE_0, 0, registering_handler, &registering, &registering_instance)
+            == ESP_OK);
+    REQUIRE(api.handler_register(TEST_EVENT_BASE_0, 1, counting_handler, &done, &done_instance) == ESP_OK);
+
+    CHECK(api.post(TEST_EVENT_BASE_0, 0, nullptr, 0, portMAX_DELAY) == ESP_OK);
+    CHECK(api.post(TEST_EVENT_BASE_0, 1, nullptr, 0, portMAX_DELAY) == ESP_OK);
+    REQUIRE(done.wait_for(1));
+    CHECK(added.get() == 0);
+
+    CHECK(api.post(TEST_EVENT_BASE_0, 0, nullptr, 0, portMAX_DELAY) == ESP_OK);
+    REQUIRE(added.wait_for(1));
+}
+
+TEST_CASE("ESPEventLoop post times out when the queue is full")
+{
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>(1));
+    mutex blocker;
+    CallCounter counter;
+
+    auto reg = loop.register_event(TEST_EVENT_0, [&](const ESPEvent &event, void *data) {
+        counter.increment();
+        lock_guard<mutex> lock(blocker);
+    });
+
+    {
+        lock_guard<mutex> lock(blocker);
+        loop.post_event_data(TEST_EVENT_0);
+        REQUIRE(counter.wait_for(1));
+        loop.post_event_data(TEST_EVENT_0);
+
+        CHECK_THROWS_AS(loop.post_event_data(TEST_EVENT_0, chrono::milliseconds(10)), idf::ESPException&);
+    }
+
+    REQUIRE(counter.wait_for(2));
+}
+
+TEST_CASE("ESPEventLoop throughput benchmark")
+{
+    constexpr size_t EVENTS = 100000;
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>(64));
+    CallCounter counter;
+    size_t in_order = 0;
+    int expected = 0;
+
+    auto reg = loop.register_event(TEST_EVENT_0, [&](const ESPEvent &event, void *data) {
+        if (*static_cast<int*>(data) == expected) {
+            in_order++;
+        }
+        expected++;
+        counter.increment();
+    });
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < static_cast<int>(EVENTS); i++) {
+        loop.post_event_data(TEST_EVENT_0, i);
+    }
+    REQUIRE(counter.wait_for(EVENTS, chrono::milliseconds(30000)));
+    auto duration = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+
+    CHECK(in_order == EVENTS);
+
+    printf("Posting and dispatching %zu events through ESPEventLoop:\n", EVENTS);
+    printf("  %lld us, %lld events/s\n", static_cast<long long>(duration.count()),
+           static_cast<long long>(EVENTS * 1000000 / max<int64_t>(duration.count(), 1)));
+}
+
+TEST_CASE("ESPEventLoop latency benchmark")
+{
+    constexpr size_t EVENTS = 10000;
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>());
+    CallCounter counter;
+    chrono::steady_clock::time_point posted;
+    chrono::nanoseconds total(0);
+    chrono::nanoseconds worst(0);
+
+    auto reg = loop.register_event(TEST_EVENT_0, [&](const ESPEvent &event, void *data) {
+        const chrono::nanoseconds latency = chrono::steady_clock::now() - posted;
+        total += latency;
+        worst = max(worst, latency);
+        counter.increment();
+    });
+
+    for (size_t i = 1; i <= EVENTS; i++) {
+        posted = chrono::steady_clock::now();
+        loop.post_event_data(TEST_EVENT_0);
+        REQUIRE(counter.wait_for(i));
+    }
+
+    printf("Latency of post_event_data to handler over %zu events:\n", EVENTS);
+    printf("  mean %lld ns, max %lld ns\n", static_cast<long long>(total.count() / EVENTS),
+           static_cast<long long>(worst.count()));
+}
+
+struct Telemetry {
+    uint32_t sequence;
+    uint8_t payload[200];
+};
+
+static const ESPTypedEvent<Telemetry> TEST_TYPED_EVENT(TEST_EVENT_BASE_1, ESPEventID(1));
+
+TEST_CASE("ESPEventLoop typed handler receives the typed data")
+{
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>());
+    CallCounter counter;
+    uint32_t received = 0;
+
+    auto reg = loop.register_event(TEST_TYPED_EVENT, [&](const ESPEvent &event, const Telemetry &data) {
+        received = data.sequence;
+        counter.increment();
+    });
+
+    Telemetry data = {};
+    data.sequence = 47;
+    loop.post_event(TEST_TYPED_EVENT, data);
+
+    REQUIRE(counter.wait_for(1));
+    CHECK(received == 47);
+}
+
+TEST_CASE("ESPEventLoop typed handler must not be empty")
+{
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>());
+
+    CHECK_THROWS_AS(loop.register_event(TEST_TYPED_EVENT, ESPTypedEvent<Telemetry>::Handler()), EventException&);
+}
+
+/**
+ * Event API keeping the posted events until dispatch() is called from the test.
+ */
+class ManualEventAPI : public ESPEventAPI {
+public:
+    esp_err_t handler_register(esp_event_base_t event_base,
+            int32_t event_id,
+            esp_event_handler_t event_handler,
+            void* event_handler_arg,
+            esp_event_handler_instance_t *instance) override
+    {
+        handlers.push_back(make_unique<Handler>(Handler{event_base, event_id, event_handler, event_handler_arg}));
+        *instance = handlers.back().get();
+        return ESP_OK;
+    }
+
+    esp_err_t handler_unregister(esp_event_base_t event_base,
+            int32_t event_id,
+            esp_event_handler_instance_t instance) override
+    {
+        handlers.erase(remove_if(handlers.begin(), handlers.end(),
+                [&](const unique_ptr<Handler> &handler) { return handler.get() == instance; }), handlers.end());
+        return ESP_OK;
+    }
+
+    esp_err_t post(esp_event_base_t event_base,
+            int32_t event_id,
+            void* event_data,
+            size_t event_data_size,
+            TickType_t ticks_to_wait) override
+    {
+        if (next_error != ESP_OK) {
+            return next_error;
+        }
+        const uint8_t *data = static_cast<const uint8_t*>(event_data);
+        events.push_back(Event{event_base, event_id, vector<uint8_t>(data, data + event_data_size)});
+        return ESP_OK;
+    }
+
+    void dispatch()
+    {
+        for (Event &event : events) {
+            for (const unique_ptr<Handler> &handler : handlers) {
+                if (handler->base == event.base && handler->id == event.id) {
+                    handler->handler(handler->arg, event.base, event.id, event.data.data());
+                }
+            }
+        }
+        events.clear();
+    }
+
+    esp_err_t next_error = ESP_OK;
+
+private:
+    struct Handler {
+        esp_event_base_t base;
+        int32_t id;
+        esp_event_handler_t handler;
+        void *arg;
+    };
+
+    struct Event {
+        esp_event_base_t base;
+        int32_t id;
+        vector<uint8_t> data;
+    };
+
+    vector<unique_ptr<Handler>> handlers;
+    vector<Event> events;
+};
+
+TEST_CASE("ESPEventLoop pooled event is freed after all its handlers")
+{
+    auto api = make_shared<ManualEventAPI>();
+    ESPEventLoop loop(api);
+    ESPPooledEvent<Telemetry, 2> event(TEST_EVENT_BASE_1, ESPEventID(2));
+    const Telemetry *first = nullptr;
+    const Telemetry *second = nullptr;
+
+    auto reg_first = loop.register_event(event, [&](const ESPEvent &event, const Telemetry &data) { first = &data; });
+    auto reg_second = loop.register_event(event, [&](const ESPEvent &event, const Telemetry &data) {
+        second = &data;
+        CHECK(data.sequence == 47);
+    });
+
+    auto data = event.acquire();
+    data->sequence = 47;
+    const Telemetry *slot = &*data;
+    loop.post_event(event, std::move(data));
+    CHECK(event.available() == 1);
+
+    api->dispatch();
+
+    CHECK(first == slot);
+    CHECK(second == slot);
+    CHECK(event.available() == 2);
+}
+
+TEST_CASE("ESPEventLoop pooled event acquire fails when the pool is empty")
+{
+    ESPPooledEvent<Telemetry, 1> event(TEST_EVENT_BASE_1, ESPEventID(2));
+
+    auto data = event.acquire();
+
+    CHECK_THROWS_AS(event.acquire(), EventException&);
+}
+
+TEST_CASE("ESPEventLoop pooled event data is freed if not posted")
+{
+    ESPPooledEvent<Telemetry, 1> event(TEST_EVENT_BASE_1, ESPEventID(2));
+
+    {
+        auto data = event.acquire();
+        CHECK(event.available() == 0);
+    }
+
+    CHECK(event.available() == 1);
+}
+
+TEST_CASE("ESPEventLoop pooled event without handler is not posted")
+{
+    auto api = make_shared<ManualEventAPI>();
+    ESPEventLoop loop(api);
+    ESPPooledEvent<Telemetry, 1> event(TEST_EVENT_BASE_1, ESPEventID(2));
+    api->next_error = ESP_FAIL;
+
+    loop.post_event(event, event.acquire());
+
+    CHECK(event.available() == 1);
+}
+
+TEST_CASE("ESPEventLoop pooled event is freed if posting fails")
+{
+    auto api = make_shared<ManualEventAPI>();
+    ESPEventLoop loop(api);
+    ESPPooledEvent<Telemetry, 1> event(TEST_EVENT_BASE_1, ESPEventID(2));
+    auto reg = loop.register_event(event, [&](const ESPEvent &event, const Telemetry &data) { });
+    api->next_error = ESP_ERR_TIMEOUT;
+
+    CHECK_THROWS_AS(loop.post_event(event, event.acquire()), idf::ESPException&);
+
+    CHECK(event.available() == 1);
+}
+
+TEST_CASE("ESPEventLoop pooled event references are released on unregistration")
+{
+    auto api = make_shared<ManualEventAPI>();
+    ESPEventLoop loop(api);
+    ESPPooledEvent<Telemetry, 1> event(TEST_EVENT_BASE_1, ESPEventID(2));
+    int calls = 0;
+    auto reg_kept = loop.register_event(event, [&](const ESPEvent &event, const Telemetry &data) { calls++; });
+    auto reg_removed = loop.register_event(event, [&](const ESPEvent &event, const Telemetry &data) { calls++; });
+
+    loop.post_event(event, event.acquire());
+    reg_removed.reset();
+    CHECK(event.available() == 0);
+    api->dispatch();
+
+    CHECK(calls == 1);
+    CHECK(event.available() == 1);
+
+    loop.post_event(event, event.acquire());
+    reg_kept.reset();
+
+    CHECK(event.available() == 1);
+}
+
+TEST_CASE("ESPEventLoop pooled handler ignores events posted before its registration")
+{
+    auto api = make_shared<ManualEventAPI>();
+    ESPEventLoop loop(api);
+    ESPPooledEvent<Telemetry, 1> event(TEST_EVENT_BASE_1, ESPEventID(2));
+    int calls = 0;
+    auto reg = loop.register_event(event, [&](const ESPEvent &event, const Telemetry &data) { calls++; });
+
+    loop.post_event(event, event.acquire());
+    auto reg_late = loop.register_event(event, [&](const ESPEvent &event, const Telemetry &data) { calls += 10; });
+    api->dispatch();
+
+    CHECK(calls == 1);
+    CHECK(event.available() == 1);
+}
+
+TEST_CASE("ESPEventLoop pooled events through the host loop")
+{
+    constexpr uint32_t EVENTS = 10000;
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>());
+    ESPPooledEvent<Telemetry, 4> event(TEST_EVENT_BASE_1, ESPEventID(2));
+    CallCounter counter;
+    uint32_t in_order = 0;
+    size_t pool_empty = 0;
+
+    auto reg_check = loop.register_event(event, [&](const ESPEvent &event, const Telemetry &data) {
+        if (data.sequence == in_order) {
+            in_order++;
+        }
+    });
+    auto reg_count = loop.register_event(event, [&](const ESPEvent &event, const Telemetry &data) {
+        counter.increment();
+    });
+
+    for (uint32_t i = 0; i < EVENTS; i++) {
+        while (event.available() == 0) {
+            pool_empty++;
+            this_thread::yield();
+        }
+        auto data = event.acquire();
+        data->sequence = i;
+        loop.post_event(event, std::move(data));
+    }
+    REQUIRE(counter.wait_for(EVENTS, chrono::milliseconds(30000)));
+    reg_check.reset();
+
+    CHECK(in_order == EVENTS);
+    CHECK(event.available() == 4);
+    printf("Pooled transfer of %u events, pool empty %zu times\n", EVENTS, pool_empty);
+}
+
+using LocalValue = LocalEvent<0, int>;
+using LocalTelemetry = LocalEvent<1, Telemetry>;
+using LocalTick = LocalEvent<2>;
+using TestBus = LocalBus<LocalValue, LocalTelemetry, LocalTick>;
+
+TEST_CASE("LocalBus dispatches synchronously to the handlers of the event")
+{
+    TestBus bus(0);
+    int value_0 = 0;
+    int value_1 = 0;
+    size_t ticks = 0;
+
+    auto reg_0 = bus.register_event(LocalValue(), [&](const int &data) { value_0 = data; });
+    auto reg_1 = bus.register_event(LocalValue(), [&](const int &data) { value_1 = data; });
+    auto reg_tick = bus.register_event(LocalTick(), [&]() { ticks++; });
+
+    bus.dispatch_event(LocalValue(), 47);
+    CHECK(value_0 == 47);
+    CHECK(value_1 == 47);
+    CHECK(ticks == 0);
+
+    bus.dispatch_event(LocalTick());
+    CHECK(ticks == 1);
+}
+
+TEST_CASE("LocalBus handler must not be empty")
+{
+    TestBus bus(0);
+
+    CHECK_THROWS_AS(bus.register_event(LocalValue(), LocalValue::Handler()), idf::ESPException&);
+}
+
+TEST_CASE("LocalBus without queue can't post")
+{
+    TestBus bus(0);
+
+    CHECK_THROWS_AS(bus.post_event(LocalTick()), idf::ESPException&);
+}
+
+TEST_CASE("LocalBus dispatches a copy of the posted data from its thread")
+{
+    TestBus bus;
+    CallCounter counter;
+    Telemetry received = {};
+    thread::id handler_thread;
+
+    auto reg = bus.register_event(LocalTelemetry(), [&](const Telemetry &data) {
+        received = data;
+        handler_thread = this_thread::get_id();
+        counter.increment();
+    });
+
+    Telemetry sent = {};
+    sent.sequence = 47;
+    sent.payload[199] = 0x5a;
+    bus.post_event(LocalTelemetry(), sent);
+    sent.sequence = 0;
+
+    REQUIRE(counter.wait_for(1));
+    CHECK(received.sequence == 47);
+    CHECK(received.payload[199] == 0x5a);
+    CHECK(handler_thread != this_thread::get_id());
+}
+
+TEST_CASE("LocalBus post times out when the queue is full")
+{
+    TestBus bus(1);
+    mutex blocker;
+    CallCounter counter;
+
+    auto reg = bus.register_event(LocalTick(), [&]() {
+        counter.increment();
+        lock_guard<mutex> lock(blocker);
+    });
+
+    {
+        lock_guard<mutex> lock(blocker);
+        bus.post_event(LocalTick());
+        REQUIRE(counter.wait_for(1));
+        bus.post_event(LocalTick());
+
+        CHECK_THROWS_AS(bus.post_event(LocalTick(), chrono::milliseconds(10)), idf::ESPException&);
+    }
+
+    REQUIRE(counter.wait_for(2));
+}
+
+TEST_CASE("LocalBus unregisters in LocalBusReg destructor")
+{
+    TestBus bus(0);
+    size_t calls = 0;
+
+    auto reg = bus.register_event(LocalTick(), [&]() { calls++; });
+    bus.dispatch_event(LocalTick());
+    reg.reset();
+    bus.dispatch_event(LocalTick());
+
+    CHECK(calls == 1);
+}
+
+TEST_CASE("LocalBus handlers can register and unregister during a dispatch")
+{
+    TestBus bus(0);
+    unique_ptr<LocalBusReg> self;
+    unique_ptr<LocalBusReg> added;
+    size_t self_calls = 0;
+    size_t added_calls = 0;
+    size_t nested_values = 0;
+
+    auto reg_value = bus.register_event(LocalValue(), [&](const int &data) { nested_values++; });
+    self = bus.register_event(LocalTick(), [&]() {
+        self_calls++;
+        added = bus.register_event(LocalTick(), [&]() { added_calls++; });
+        bus.dispatch_event(LocalValue(), 0);
+        self.reset();
+    });
+
+    bus.dispatch_event(LocalTick());
+    CHECK(self_calls == 1);
+    CHECK(added_calls == 0);
+    CHECK(nested_values == 1);
+
+    bus.dispatch_event(LocalTick());
+    CHECK(self_calls == 1);
+    CHECK(added_calls == 1);
+}
+
+TEST_CASE("LocalBus throughput benchmark")
+{
+    constexpr size_t EVENTS = 100000;
+    TestBus bus(64);
+    CallCounter counter;
+    size_t in_order = 0;
+    int expected = 0;
+
+    auto reg = bus.register_event(LocalValue(), [&](const int &data) {
+        if (data == expected) {
+            in_order++;
+        }
+        expected++;
+        counter.increment();
+    });
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < static_cast<int>(EVENTS); i++) {
+        bus.post_event(LocalValue(), i);
+    }
+    REQUIRE(counter.wait_for(EVENTS, chrono::milliseconds(30000)));
+    auto queued = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+
+    CHECK(in_order == EVENTS);
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < static_cast<int>(EVENTS); i++) {
+        bus.dispatch_event(LocalValue(), static_cast<int>(EVENTS) + i);
+    }
+    auto sync = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+
+    CHECK(in_order == 2 * EVENTS);
+
+    printf("Posting and dispatching %zu events through LocalBus:\n", EVENTS);
+    printf("  queued %lld us, %lld events/s\n", static_cast<long long>(queued.count()),
+           static_cast<long long>(EVENTS * 1000000 / max<int64_t>(queued.count(), 1)));
+    printf("  synchronous %lld us, %lld events/s\n", static_cast<long long>(sync.count()),
+           static_cast<long long>(EVENTS * 1000000 / max<int64_t>(sync.count(), 1)));
+}
+
+TEST_CASE("ESPEventLoop post_batch dispatches the events in order")
+{
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>(4));
+    CallCounter counter;
+    vector<int> received;
+
+    auto reg_0 = loop.register_event(TEST_EVENT_0, [&](const ESPEvent &event, void *data) {
+        received.push_back(*static_cast<int*>(data));
+        counter.increment();
+    });
+    auto reg_1 = loop.register_event(TEST_EVENT_1, [&](const ESPEvent &event, void *data) {
+        received.push_back(-1);
+        counter.increment();
+    });
+
+    int first = 47;
+    int second = 48;
+    static_assert(is_constructible_v<ESPEventBatchItem, const ESPEvent&, int&>);
+    static_assert(!is_constructible_v<ESPEventBatchItem, const ESPEvent&, int>);
+    array<ESPEventBatchItem, 3> batch = {
+        ESPEventBatchItem(TEST_EVENT_0, first),
+        ESPEventBatchItem(TEST_EVENT_1),
+        ESPEventBatchItem(TEST_EVENT_0, second),
+    };
+    loop.post_batch(batch);
+
+    REQUIRE(counter.wait_for(3));
+    CHECK(received == vector<int>({47, -1, 48}));
+}
+
+TEST_CASE("ESPEventLoop post_batch larger than the host queue fails")
+{
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>(2));
+    array<ESPEventBatchItem, 3> batch = {
+        ESPEventBatchItem(TEST_EVENT_0),
+        ESPEventBatchItem(TEST_EVENT_0),
+        ESPEventBatchItem(TEST_EVENT_0),
+    };
+
+    esp_err_t error = ESP_OK;
+    try {
+        loop.post_batch(batch);
+    } catch (const idf::ESPException &e) {
+        error = e.error;
+    }
+    CHECK(error == ESP_ERR_INVALID_SIZE);
+}
+
+TEST_CASE("ESPEventLoop post_batch posts one by one without batch support")
+{
+    auto api = make_shared<ManualEventAPI>();
+    ESPEventLoop loop(api);
+    int sum = 0;
+
+    auto reg = loop.register_event(TEST_EVENT_0, [&](const ESPEvent &event, void *data) {
+        sum += *static_cast<int*>(data);
+    });
+
+    int first = 1;
+    int second = 2;
+    array<ESPEventBatchItem, 2> batch = {ESPEventBatchItem(TEST_EVENT_0, first), ESPEventBatchItem(TEST_EVENT_0, second)};
+    loop.post_batch(batch);
+    api->dispatch();
+
+    CHECK(sum == 3);
+}
+
+TEST_CASE("ESPEventLoop coalesced event only dispatches the latest value")
+{
+    auto api = make_shared<ManualEventAPI>();
+    ESPEventLoop loop(api);
+    ESPCoalescedEvent<int> event(TEST_EVENT_BASE_1, ESPEventID(3));
+    vector<int> received;
+
+    auto reg = loop.register_event(event, [&](const ESPEvent &event_id, const int &value) {
+        received.push_back(value);
+    });
+
+    loop.post_event(event, 1);
+    loop.post_event(event, 2);
+    loop.post_event(event, 3);
+    api->dispatch();
+    CHECK(received == vector<int>({3}));
+    CHECK(event.get_coalesced_count() == 2);
+
+    loop.post_event(event, 4);
+    api->dispatch();
+    CHECK(received == vector<int>({3, 4}));
+    CHECK(event.get_coalesced_count() == 2);
+}
+
+TEST_CASE("ESPEventLoop coalesced event without handler is not posted")
+{
+    ESPEventLoop loop(make_shared<ManualEventAPI>());
+    ESPCoalescedEvent<int> event(TEST_EVENT_BASE_1, ESPEventID(3));
+
+    loop.post_event(event, 1);
+    loop.post_event(event, 2);
+
+    CHECK(event.get_coalesced_count() == 0);
+}
+
+TEST_CASE("ESPEventLoop coalesced event is queued again after a failed post")
+{
+    auto api = make_shared<ManualEventAPI>();
+    ESPEventLoop loop(api);
+    ESPCoalescedEvent<int> event(TEST_EVENT_BASE_1, ESPEventID(3));
+    vector<int> received;
+
+    auto reg = loop.register_event(event, [&](const ESPEvent &event_id, const int &value) {
+        received.push_back(value);
+    });
+
+    api->next_error = ESP_ERR_TIMEOUT;
+    CHECK_THROWS_AS(loop.post_event(event, 1), idf::ESPException&);
+    api->next_error = ESP_OK;
+    loop.post_event(event, 2);
+    api->dispatch();
+
+    CHECK(received == vector<int>({2}));
+    CHECK(event.get_coalesced_count() == 0);
+}
+
+TEST_CASE("ESPEventLoop coalesced event is queued again after unregistering its handlers")
+{
+    auto api = make_shared<ManualEventAPI>();
+    ESPEventLoop loop(api);
+    ESPCoalescedEvent<int> event(TEST_EVENT_BASE_1, ESPEventID(3));
+    vector<int> received;
+    auto handler = [&](const ESPEvent &event_id, const int &value) { received.push_back(value); };
+
+    auto reg = loop.register_event(event, handler);
+    loop.post_event(event, 1);
+    reg.reset();
+
+    reg = loop.register_event(event, handler);
+    loop.post_event(event, 2);
+    api->dispatch();
+
+    CHECK(event.get_coalesced_count() == 0);
+    CHECK(received.back() == 2);
+}
+
+TEST_CASE("ESPEventLoop coalesced posts don't wait behind a slow handler")
+{
+    constexpr int VALUES = 1000;
+    ESPEventLoop loop(make_shared<ESPEventAPIHost>(1));
+    ESPCoalescedEvent<int> event(TEST_EVENT_BASE_1, ESPEventID(3));
+    mutex blocker;
+    CallCounter counter;
+    int last = -1;
+
+    auto reg = loop.register_event(event, [&](const ESPEvent &event_id, const int &value) {
+        last = value;
+        counter.increment();
+        lock_guard<mutex> lock(blocker);
+    });
+
+    {
+        lock_guard<mutex> lock(blocker);
+        loop.post_event(event, 0);
+        REQUIRE(counter.wait_for(1));
+        for (int i = 1; i <= VALUES; i++) {
+            loop.post_event(event, i, chrono::milliseconds(0));
+        }
+    }
+
+    REQUIRE(counter.wait_for(2));
+    this_thread::sleep_for(chrono::milliseconds(10));
+    CHECK(counter.get() == 2);
+    CHECK(last == VALUES);
+    CHECK(event.get_coalesced_count() == VALUES - 1);
+}
@@ -16,8 +16,10 @@
 
 #include <stdio.h>
 #include <stdexcept>
+#include <memory>
 #include "esp_err.h"
 #include "esp_timer_cxx.hpp"
+#include "timer_wheel_cxx.hpp"
 
 #include "catch.hpp"
 
@@ -98,6 +100,14 @@ TEST_CASE("get_next_alarm works")
     CHECK(get_next_alarm() == std::chrono::microseconds(47u));
 }
 
+TEST_CASE("clock is a clock of the standard library")
+{
+    static_assert(chrono::is_clock_v<idf::esp_timer::clock>);
+    esp_timer_get_time_ExpectAndReturn(static_cast<uint64_t>(47u));
+
+    CHECK(idf::esp_timer::clock::now().time_since_epoch() == chrono::microseconds(47u));
+}
+
 TEST_CASE("ESPTimer null function")
 {
     CHECK_THROWS_AS(ESPTimer(nullptr), ESPException&);
@@ -186,6 +196,93 @@ TEST_CASE("ESPTimer stops correctly")
     timer.stop();
 }
 
+TEST_CASE("ESPTimer try_stop returns false if not running")
+{
+    TimerCreationFixture fix;
+
+    // Overriding stop part of the fixture
+    esp_timer_stop_StopIgnore();
+    esp_timer_stop_IgnoreAndReturn(ESP_ERR_INVALID_STATE);
+
+    ESPTimer timer([]() { });
+
+    CHECK(timer.try_stop() == false);
+}
+
+TEST_CASE("ESPTimer try_stop returns true if running")
+{
+    TimerCreationFixture fix(true);
+    esp_timer_stop_ExpectAndReturn(fix.out_handle, ESP_OK);
+
+    ESPTimer timer([]() { });
+
+    CHECK(timer.try_stop() == true);
+}
+
+TEST_CASE("ESPTimer restart restarts a running timer")
+{
+    TimerCreationFixture fix;
+    esp_timer_restart_ExpectAndReturn(fix.out_handle, 5000, ESP_OK);
+
+    ESPTimer timer([]() { });
+
+    timer.restart(chrono::microseconds(5000));
+}
+
+TEST_CASE("ESPTimer restart starts a stopped timer")
+{
+    TimerCreationFixture fix;
+    esp_timer_restart_ExpectAndReturn(fix.out_handle, 5000, ESP_ERR_INVALID_STATE);
+    esp_timer_start_once_ExpectAndReturn(fix.out_handle, 5000, ESP_OK);
+
+    ESPTimer timer([]() { });
+
+    timer.restart(chrono::microseconds(5000));
+}
+
+TEST_CASE("ESPTimer restart throws on other failures")
+{
+    TimerCreationFixture fix;
+    esp_timer_restart_ExpectAndReturn(fix.out_handle, 5000, ESP_ERR_NO_MEM);
+
+    ESPTimer timer([]() { });
+
+    CHECK_THROWS_AS(timer.restart(chrono::microseconds(5000)), ESPException&);
+}
+
+TEST_CASE("ESPTimer start_at starts after the remaining time")
+{
+    TimerCreationFixture fix;
+    esp_timer_get_time_ExpectAndReturn(1000);
+    esp_timer_start_once_ExpectAndReturn(fix.out_handle, 4000, ESP_OK);
+
+    ESPTimer timer([]() { });
+
+    timer.start_at(chrono::microseconds(5000));
+}
+
+TEST_CASE("ESPTimer start_at accepts a time point of clock")
+{
+    TimerCreationFixture fix;
+    esp_timer_get_time_ExpectAndReturn(1000);
+    esp_timer_start_once_ExpectAndReturn(fix.out_handle, 4000, ESP_OK);
+
+    ESPTimer timer([]() { });
+
+    timer.start_at(idf::esp_timer::clock::time_point(chrono::microseconds(5000)));
+}
+
+TEST_CASE("ESPTimer start_at starts immediately if the time is passed")
+{
+    TimerCreationFixture fix;
+    esp_timer_get_time_ExpectAndReturn(6000);
+    esp_timer_start_once_ExpectAndReturn(fix.out_handle, 0, ESP_OK);
+
+    ESPTimer timer([]() { });
+
+    timer.start_at(chrono::microseconds(5000));
+}
+
 TEST_CASE("ESPTimer callback works")
 {
     TimerCallbackFixture fix;
@@ -200,3 +297,281 @@ TEST_CASE("ESPTimer callback works")
     REQUIRE(trigger_timer_callback != nullptr);
     CHECK(flag == 47);
 }
+
+static esp_timer_create_args_t created_timer_args;
+
+static esp_err_t cmock_timer_create_save_args(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle, int cmock_num_calls)
+{
+    created_timer_args = *create_args;
+    return ESP_OK;
+}
+
+TEST_CASE("ESPTimer passes skip_unhandled_events")
+{
+    TimerCreationFixture fix;
+    esp_timer_create_AddCallback(cmock_timer_create_save_args);
+
+    ESPTimer timer([]() { }, "test", true);
+
+    CHECK(created_timer_args.dispatch_method == ESP_TIMER_TASK);
+    CHECK(created_timer_args.skip_unhandled_events == true);
+}
+
+TEST_CASE("ESPTimer stores a lambda inline and keeps the name pointer")
+{
+    TimerCreationFixture fix;
+    esp_timer_create_AddCallback(cmock_timer_create_save_args);
+    static const char name[] = "inline";
+    int flag = 0;
+
+    ESPTimer timer([&flag]() { flag = 47; }, StaticName(name));
+    created_timer_args.callback(created_timer_args.arg);
+
+    CHECK(created_timer_args.name == name);
+    CHECK(flag == 47);
+}
+
+TEST_CASE("ESPTimer copies a name which is not a StaticName")
+{
+    TimerCreationFixture fix;
+    esp_timer_create_AddCallback(cmock_timer_create_save_args);
+    char name[] = "local";
+
+    ESPTimer timer([]() { }, name);
+    name[0] = 'X';
+
+    CHECK(created_timer_args.name != name);
+    CHECK(string(created_timer_args.name) == "local");
+}
+
+static int function_pointer_calls;
+
+static void function_pointer_cb()
+{
+    function_pointer_calls++;
+}
+
+TEST_CASE("ESPTimer calls a function pointer")
+{
+    TimerCreationFixture fix;
+    esp_timer_create_AddCallback(cmock_timer_create_save_args);
+    function_pointer_calls = 0;
+
+    ESPTimer timer(function_pointer_cb);
+    created_timer_args.callback(created_timer_args.arg);
+
+    CHECK(function_pointer_calls == 1);
+}
+
+TEST_CASE("ESPTimer null function pointer")
+{
+    void (*nothing)() = nullptr;
+    CHECK_THROWS_AS(ESPTimer(nothing, StaticName("test")), ESPException&);
+}
+
+TEST_CASE("ESPTimer destroys the inline callback")
+{
+    auto counter = make_shared<int>(0);
+    {
+        TimerCreationFixture fix;
+        ESPTimer timer([counter]() { (*counter)++; }, StaticName("test"));
+        CHECK(counter.use_count() == 2);
+    }
+    CHECK(counter.use_count() == 1);
+}
+
+static int64_t fake_time_us;
+
+static int64_t cmock_get_time(int cmock_num_calls)
+{
+    return fake_time_us;
+}
+
+struct StubbedTimerFixture {
+    StubbedTimerFixture()
+    {
+        if (!TEST_PROTECT()) {
+            throw FixtureException();
+        }
+        fake_time_us = 0;
+        esp_timer_get_time_Stub(cmock_get_time);
+        esp_timer_create_Stub(cmock_timer_create_save_args);
+        esp_timer_start_periodic_IgnoreAndReturn(ESP_OK);
+        esp_timer_stop_IgnoreAndReturn(ESP_OK);
+        esp_timer_delete_IgnoreAndReturn(ESP_OK);
+        esp_timer_is_active_IgnoreAndReturn(false);
+    }
+
+    void advance(int64_t time_us)
+    {
+        fake_time_us += time_us;
+        created_timer_args.callback(created_timer_args.arg);
+    }
+};
+
+static void count_expiry(void *arg)
+{
+    (*static_cast<int *>(arg))++;
+}
+
+TEST_CASE("TimerWheel timer expires after its timeout")
+{
+    StubbedTimerFixture fix;
+    TimerWheel wheel(chrono::milliseconds(1));
+    int count = 0;
+    TimerWheel::Timer timer(wheel, count_expiry, &count);
+
+    timer.start(chrono::microseconds(2500));
+    CHECK(timer.is_active());
+    fix.advance(2000);
+    CHECK(count == 0);
+    fix.advance(1000);
+    CHECK(count == 1);
+    CHECK_FALSE(timer.is_active());
+    CHECK(wheel.active_count() == 0u);
+}
+
+TEST_CASE("TimerWheel stopped and restarted timers")
+{
+    StubbedTimerFixture fix;
+    TimerWheel wheel(chrono::milliseconds(1));
+    int stopped_count = 0;
+    int restarted_count = 0;
+    TimerWheel::Timer stopped(wheel, count_expiry, &stopped_count);
+    TimerWheel::Timer restarted(wheel, count_expiry, &restarted_count);
+
+    stopped.start(chrono::milliseconds(5));
+    restarted.start(chrono::milliseconds(5));
+    CHECK(wheel.active_count() == 2u);
+    fix.advance(4000);
+    stopped.stop();
+    restarted.start(chrono::milliseconds(5));
+    fix.advance(4000);
+    CHECK(restarted_count == 0);
+    fix.advance(1000);
+
+    CHECK(stopped_count == 0);
+    CHECK(restarted_count == 1);
+}
+
+TEST_CASE("TimerWheel long timeouts cascade through the levels")
+{
+    StubbedTimerFixture fix;
+    TimerWheel wheel(chrono::milliseconds(1));
+    int count = 0;
+    TimerWheel::Timer timer(wheel, count_expiry, &count);
+
+    // More than 64 * 64 * 64 ticks
+    timer.start(chrono::seconds(300));
+    for (int i = 0; i < 299; i++)
+        fix.advance(1000000);
+    CHECK(count == 0);
+    fix.advance(1000000);
+    CHECK(count == 1);
+}
+
+TEST_CASE("TimerWheel timeouts beyond the range of the wheel")
+{
+    StubbedTimerFixture fix;
+    TimerWheel wheel(chrono::milliseconds(1));
+    int beyond_count = 0;
+    int far_beyond_count = 0;
+    TimerWheel::Timer beyond(wheel, count_expiry, &beyond_count);
+    TimerWheel::Timer far_beyond(wheel, count_expiry, &far_beyond_count);
+
+    // The wheel covers 64^4 = 2^24 ticks
+    beyond.start(chrono::milliseconds(20000000));
+    far_beyond.start(chrono::milliseconds(40000000));
+    for (int i = 0; i < 19; i++)
+        fix.advance(1000000000);
+    fix.advance(999999000);
+    CHECK(beyond_count == 0);
+    fix.advance(1000);
+    CHECK(beyond_count == 1);
+
+    fix.advance(19999999000);
+    CHECK(far_beyond_count == 0);
+    fix.advance(1000);
+    CHECK(far_beyond_count == 1);
+    CHECK(wheel.active_count() == 0u);
+}
+
+TEST_CASE("ESPTimer get_stats throws if the statistics are not enabled")
+{
+    StubbedTimerFixture fix;
+    ESPTimer timer([]() { });
+
+    CHECK_THROWS_AS(timer.get_stats(), ESPException&);
+}
+
+TEST_CASE("ESPTimer measures the lateness and execution time of a periodic timer")
+{
+    StubbedTimerFixture fix;
+    ESPTimer timer([]() { fake_time_us += 100; });
+    timer.enable_stats();
+
+    timer.start_periodic(chrono::microseconds(1000));
+    fix.advance(1010);
+    fix.advance(900);
+    fix.advance(930);
+
+    const ESPTimer::Stats stats = timer.get_stats();
+    CHECK(stats.calls == 3u);
+    CHECK(stats.missed_periods == 0u);
+    CHECK(stats.max_lateness == chrono::microseconds(40));
+    CHECK(stats.mean_lateness == chrono::microseconds(20));
+    CHECK(stats.max_execution_time == chrono::microseconds(100));
+    CHECK(stats.mean_execution_time == chrono::microseconds(100));
+}
+
+TEST_CASE("ESPTimer counts the periods whose callback is late by a full period")
+{
+    StubbedTimerFixture fix;
+    ESPTimer timer([]() { });
+    timer.enable_stats();
+
+    timer.start_periodic(chrono::microseconds(1000));
+    // The calls of the periods at 1000, 2000 and 3000 all happen at 3500
+    fix.advance(3500);
+    fix.advance(0);
+    fix.advance(0);
+
+    const ESPTimer::Stats stats = timer.get_stats();
+    CHECK(stats.calls == 3u);
+    CHECK(stats.missed_periods == 2u);
+    CHECK(stats.max_lateness == chrono::microseconds(2500));
+}
+
+TEST_CASE("ESPTimer counts the periods skipped with skip_unhandled_events")
+{
+    StubbedTimerFixture fix;
+    ESPTimer timer([]() { }, "test", true);
+    timer.enable_stats();
+
+    timer.start_periodic(chrono::microseconds(1000));
+    // The period at 1000 is called at 3500, esp_timer skips the ones at 2000 and 3000 and calls the next one at 4000
+    fix.advance(3500);
+    fix.advance(500);
+    fix.advance(1000);
+
+    const ESPTimer::Stats stats = timer.get_stats();
+    CHECK(stats.calls == 3u);
+    CHECK(stats.missed_periods == 3u);
+    CHECK(stats.max_lateness == chrono::microseconds(2500));
+    CHECK(stats.mean_lateness == chrono::microseconds(833));
+}
+
+TEST_CASE("ESPTimer reset_stats clears the statistics")
+{
+    StubbedTimerFixture fix;
+    ESPTimer timer([]() { });
+    timer.enable_stats();
+
+    timer.start_periodic(chrono::microseconds(1000));
+    fix.advance(1500);
+    timer.reset_stats();
+
+    const ESPTimer::Stats stats = timer.get_stats();
+    CHECK(stats.calls == 0u);
+    CHECK(stats.max_lateness == chrono::microseconds(0));
+}
@@ -15,15 +15,19 @@
 #define CATCH_CONFIG_MAIN
 
 #include <stdio.h>
+#include <vector>
 #include "esp_err.h"
 #include "freertos/portmacro.h"
 #include "gpio_cxx.hpp"
+#include "gpio_debounce_cxx.hpp"
+#include "gpio_edge_recorder_cxx.hpp"
 #include "test_fixtures.hpp"
 
 #include "catch.hpp"
 
 extern "C" {
 #include "Mockgpio.h"
+#include "Mockesp_timer.h"
 }
 
 // TODO: IDF-2693, function definition just to satisfy linker, mock esp_common instead
@@ -71,6 +75,7 @@ TEST_CASE("pull mode create functions work as expected")
     CHECK(GPIOPullMode::FLOATING().get_value() == 3);
     CHECK(GPIOPullMode::PULLUP().get_value() == 0);
     CHECK(GPIOPullMode::PULLDOWN().get_value() == 1);
+    CHECK(GPIOPullMode::PULLUP_PULLDOWN().get_value() == 2);
 }
 
 TEST_CASE("GPIOIntrType create functions work as expected")
@@ -401,3 +406,408 @@ TEST_CASE("GPIO_OpenDrain get drive strength")
 
     CHECK(gpio.get_drive_strength() == GPIODriveStrength::STRONGEST());
 }
+
+TEST_CASE("GPIOBus configures all pins with one driver call")
+{
+    CMOCK_SETUP();
+    gpio_config_ExpectAnyArgsAndReturn(ESP_OK);
+
+    GPIOBus<3> bus({GPIONum(4), GPIONum(5), GPIONum(6)});
+
+    Mockgpio_Verify();
+}
+
+TEST_CASE("GPIOBus rejects a pin used twice")
+{
+    CHECK_THROWS_AS(GPIOBus<2>({GPIONum(4), GPIONum(4)}), GPIOException&);
+}
+
+TEST_CASE("GPIOBus write consecutive pins")
+{
+    CMOCK_SETUP();
+    gpio_config_ExpectAnyArgsAndReturn(ESP_OK);
+    gpio_reg::simulated_registers.out[0] = 0x80000001u;
+
+    GPIOBus<3> bus({GPIONum(4), GPIONum(5), GPIONum(6)});
+    bus.write(0x5u);
+
+    CHECK(gpio_reg::simulated_registers.out[0] == 0x80000051u);
+    CHECK(bus.read_output() == 0x5u);
+
+    bus.write(0xfau);
+
+    CHECK(gpio_reg::simulated_registers.out[0] == 0x80000021u);
+    CHECK(bus.read_output() == 0x2u);
+}
+
+TEST_CASE("GPIOBus write changes the pins of a bank with one store")
+{
+    CMOCK_SETUP();
+    gpio_config_ExpectAnyArgsAndReturn(ESP_OK);
+    gpio_reg::simulated_registers.out[0] = (1u << 18);
+
+    GPIOBus<3> bus({GPIONum(2), GPIONum(18), GPIONum(7)});
+    const uint32_t store_count = gpio_reg::simulated_registers.out_store_count[0];
+    bus.write(0x5u);
+
+    CHECK(gpio_reg::simulated_registers.out[0] == ((1u << 2) | (1u << 7)));
+    CHECK(gpio_reg::simulated_registers.out_store_count[0] == store_count + 1u);
+}
+
+TEST_CASE("GPIOBus write scattered pins")
+{
+    CMOCK_SETUP();
+    gpio_config_ExpectAnyArgsAndReturn(ESP_OK);
+    gpio_reg::simulated_registers.out[0] = 0u;
+    gpio_reg::simulated_registers.out[1] = 0u;
+
+    GPIOBus<3> bus({GPIONum(33), GPIONum(2), GPIONum(18)});
+    bus.write(0x7u);
+
+    CHECK(gpio_reg::simulated_registers.out[0] == ((1u << 2) | (1u << 18)));
+    CHECK(gpio_reg::simulated_registers.out[1] == (1u << 1));
+
+    bus.clear_bits(0x1u);
+    CHECK(bus.read_output() == 0x6u);
+    bus.set_bits(0x1u);
+    CHECK(bus.read_output() == 0x7u);
+}
+
+TEST_CASE("output fast functions write the registers")
+{
+    GPIOFixture fix;
+    gpio_reg::simulated_registers.out[0] = 0u;
+
+    GPIO_Output gpio(fix.num);
+
+    gpio.set();
+    CHECK(gpio_reg::simulated_registers.out[0] == (1u << 18));
+    gpio.toggle();
+    CHECK(gpio_reg::simulated_registers.out[0] == 0u);
+    gpio.write(true);
+    CHECK(gpio_reg::simulated_registers.out[0] == (1u << 18));
+    gpio.clear();
+    CHECK(gpio_reg::simulated_registers.out[0] == 0u);
+}
+
+namespace {
+
+gpio_isr_t g_isr_handler;
+void *g_isr_arg;
+
+esp_err_t cmock_isr_handler_add_callback(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args, int cmock_num_calls)
+{
+    g_isr_handler = isr_handler;
+    g_isr_arg = args;
+    return ESP_OK;
+}
+
+struct EdgeCounter {
+    static void on_edge(EdgeCounter *counter)
+    {
+        counter->count++;
+    }
+
+    int count = 0;
+};
+
+} // namespace
+
+TEST_CASE("GPIOInput on_edge calls the handler directly")
+{
+    GPIOFixture fix(VALID_GPIO, GPIO_MODE_INPUT);
+    gpio_set_intr_type_ExpectAndReturn(static_cast<gpio_num_t>(fix.num.get_value()), GPIO_INTR_DISABLE, ESP_OK);
+    gpio_set_intr_type_ExpectAndReturn(static_cast<gpio_num_t>(fix.num.get_value()), GPIO_INTR_POSEDGE, ESP_OK);
+    gpio_install_isr_service_ExpectAndReturn(0, ESP_OK);
+    gpio_isr_handler_add_Stub(cmock_isr_handler_add_callback);
+    gpio_isr_handler_remove_ExpectAndReturn(static_cast<gpio_num_t>(fix.num.get_value()), ESP_OK);
+    gpio_uninstall_isr_service_Expect();
+    EdgeCounter counter;
+
+    {
+        GPIOInput gpio(fix.num);
+        gpio.on_edge<&EdgeCounter::on_edge>(&counter, GPIO_INTR_POSEDGE);
+
+        CHECK(g_isr_arg == &counter);
+        g_isr_handler(g_isr_arg);
+        g_isr_handler(g_isr_arg);
+        CHECK(counter.count == 2);
+
+        CHECK_THROWS_AS(gpio.on_edge<&EdgeCounter::on_edge>(&counter), GPIOException&);
+    }
+}
+
+TEST_CASE("GPIOInput on_edge leaves the interrupt disabled if the ISR service can't be installed")
+{
+    GPIOFixture fix(VALID_GPIO, GPIO_MODE_INPUT);
+    gpio_set_intr_type_ExpectAndReturn(static_cast<gpio_num_t>(fix.num.get_value()), GPIO_INTR_DISABLE, ESP_OK);
+    gpio_install_isr_service_ExpectAndReturn(0, ESP_ERR_NO_MEM);
+    EdgeCounter counter;
+
+    GPIOInput gpio(fix.num);
+    CHECK_THROWS_AS(gpio.on_edge<&EdgeCounter::on_edge>(&counter, GPIO_INTR_POSEDGE), GPIOException&);
+    CHECK(GPIOISRService::get_user_count() == 0u);
+}
+
+TEST_CASE("GPIOInput on_edge disables the interrupt again if the handler can't be added")
+{
+    GPIOFixture fix(VALID_GPIO, GPIO_MODE_INPUT);
+    gpio_set_intr_type_ExpectAndReturn(static_cast<gpio_num_t>(fix.num.get_value()), GPIO_INTR_DISABLE, ESP_OK);
+    gpio_install_isr_service_ExpectAndReturn(0, ESP_OK);
+    gpio_set_intr_type_ExpectAndReturn(static_cast<gpio_num_t>(fix.num.get_value()), GPIO_INTR_POSEDGE, ESP_OK);
+    gpio_isr_handler_add_ExpectAnyArgsAndReturn(ESP_ERR_INVALID_STATE);
+    gpio_set_intr_type_ExpectAndReturn(static_cast<gpio_num_t>(fix.num.get_value()), GPIO_INTR_DISABLE, ESP_OK);
+    gpio_uninstall_isr_service_Expect();
+    EdgeCounter counter;
+
+    GPIOInput gpio(fix.num);
+    CHECK_THROWS_AS(gpio.on_edge<&EdgeCounter::on_edge>(&counter, GPIO_INTR_POSEDGE), GPIOException&);
+    CHECK(GPIOISRService::get_user_count() == 0u);
+}
+
+TEST_CASE("GPIOInput on_edge accepts a function object")
+{
+    GPIOFixture fix(VALID_GPIO, GPIO_MODE_INPUT);
+    gpio_set_intr_type_ExpectAnyArgsAndReturn(ESP_OK);
+    gpio_set_intr_type_ExpectAndReturn(static_cast<gpio_num_t>(fix.num.get_value()), GPIO_INTR_ANYEDGE, ESP_OK);
+    gpio_install_isr_service_ExpectAndReturn(0, ESP_OK);
+    gpio_isr_handler_add_Stub(cmock_isr_handler_add_callback);
+    gpio_isr_handler_remove_ExpectAnyArgsAndReturn(ESP_OK);
+    gpio_uninstall_isr_service_Expect();
+    int count = 0;
+    auto handler = [&count]() { count++; };
+
+    {
+        GPIOInput gpio(fix.num);
+        gpio.on_edge(handler);
+
+        g_isr_handler(g_isr_arg);
+        CHECK(count == 1);
+    }
+}
+
+TEST_CASE("GPIOEdgeRecorder records edges by batches")
+{
+    GPIOFixture fix(VALID_GPIO, GPIO_MODE_INPUT);
+    gpio_set_intr_type_ExpectAnyArgsAndReturn(ESP_OK);
+    gpio_set_intr_type_ExpectAndReturn(static_cast<gpio_num_t>(fix.num.get_value()), GPIO_INTR_ANYEDGE, ESP_OK);
+    gpio_install_isr_service_ExpectAndReturn(0, ESP_OK);
+    gpio_isr_handler_add_Stub(cmock_isr_handler_add_callback);
+    gpio_isr_handler_remove_ExpectAnyArgsAndReturn(ESP_OK);
+    gpio_uninstall_isr_service_Expect();
+    gpio_reg::simulated_registers.in[0] = 0u;
+
+    {
+        GPIOEdgeRecorder<2, 1> recorder({fix.num});
+        std::array<GPIOEdge, 4> edges;
+
+        for (int64_t time = 100; time <= 300; time += 100) {
+            esp_timer_get_time_ExpectAndReturn(time);
+            gpio_reg::simulated_registers.in[0] ^= 1u << 18;
+            g_isr_handler(g_isr_arg);
+        }
+
+        REQUIRE(recorder.receive(edges, 0) == 2u);
+        CHECK(edges[0].pin == 18u);
+        CHECK(edges[0].level == true);
+        CHECK(edges[0].timestamp == 100);
+        CHECK(edges[1].level == false);
+        CHECK(edges[1].timestamp == 200);
+        CHECK(recorder.dropped() == 1u);
+        CHECK(recorder.receive(edges, 0) == 0u);
+    }
+    Mockesp_timer_Verify();
+}
+
+TEST_CASE("GPIOISRService installs once with the configured flags")
+{
+    CMOCK_SETUP();
+    gpio_reset_pin_IgnoreAndReturn(ESP_OK);
+    gpio_set_direction_IgnoreAndReturn(ESP_OK);
+    gpio_set_intr_type_IgnoreAndReturn(ESP_OK);
+    gpio_isr_handler_add_IgnoreAndReturn(ESP_OK);
+    gpio_isr_handler_remove_IgnoreAndReturn(ESP_OK);
+    gpio_install_isr_service_ExpectAndReturn(ESP_INTR_FLAG_LEVEL3 | ESP_INTR_FLAG_IRAM, ESP_OK);
+    gpio_uninstall_isr_service_Expect();
+    EdgeCounter counter;
+
+    GPIOISRService::set_flags(ESP_INTR_FLAG_LEVEL3 | ESP_INTR_FLAG_IRAM);
+    {
+        GPIOInput first(GPIONum(4));
+        first.on_edge<&EdgeCounter::on_edge>(&counter);
+        GPIOInput second(GPIONum(5));
+        second.on_edge<&EdgeCounter::on_edge>(&counter);
+
+        CHECK(GPIOISRService::get_user_count() == 2u);
+        CHECK_THROWS_AS(GPIOISRService::set_flags(0), GPIOException&);
+    }
+    CHECK(GPIOISRService::get_user_count() == 0u);
+    GPIOISRService::set_flags(0);
+
+    Mockgpio_Verify();
+}
+
+TEST_CASE("GPIOISRService does not uninstall a service installed by other code")
+{
+    CMOCK_SETUP();
+    gpio_install_isr_service_ExpectAndReturn(0, ESP_ERR_INVALID_STATE);
+
+    GPIOISRService::acquire();
+    GPIOISRService::release();
+
+    Mockgpio_Verify();
+}
+
+namespace {
+
+esp_timer_cb_t g_timer_callback;
+void *g_timer_arg;
+
+esp_err_t cmock_timer_create_callback(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle, int cmock_num_calls)
+{
+    g_timer_callback = create_args->callback;
+    g_timer_arg = create_args->arg;
+    return ESP_OK;
+}
+
+void sample_inputs(uint32_t bank0)
+{
+    gpio_reg::simulated_registers.in[0] = bank0;
+    g_timer_callback(g_timer_arg);
+}
+
+} // namespace
+
+namespace {
+
+std::vector<gpio_config_t> g_gpio_configs;
+
+esp_err_t cmock_gpio_config_callback(const gpio_config_t *config, int cmock_num_calls)
+{
+    g_gpio_configs.push_back(*config);
+    return ESP_OK;
+}
+
+} // namespace
+
+TEST_CASE("GPIODebounceGroup reports stable changes only")
+{
+    CMOCK_SETUP();
+    gpio_config_ExpectAnyArgsAndReturn(ESP_OK);
+    esp_timer_create_Stub(cmock_timer_create_callback);
+    esp_timer_start_periodic_ExpectAnyArgsAndReturn(ESP_OK);
+    esp_timer_stop_ExpectAnyArgsAndReturn(ESP_OK);
+    esp_timer_delete_ExpectAnyArgsAndReturn(ESP_OK);
+    gpio_reg::simulated_registers.in[0] = 1u << 5;
+    const std::array<GPIONum, 2> pins = {GPIONum(2), GPIONum(5)};
+    string log;
+
+    {
+        GPIODebounceGroup group(pins, [&log](GPIONum num, bool level) {
+            log += to_string(num.get_value()) + (level ? "H" : "L");
+        });
+        CHECK(group.get_level(GPIONum(5)) == true);
+        CHECK(group.get_level(GPIONum(2)) == false);
+
+        // A bounce restarts the count
+        sample_inputs((1u << 2) | (1u << 5));
+        sample_inputs(1u << 5);
+        for (uint32_t i = 0u; i < GPIODebounceGroup::SAMPLE_COUNT - 1u; i++)
+            sample_inputs((1u << 2) | (1u << 5));
+        CHECK(log.empty());
+
+        sample_inputs((1u << 2) | (1u << 5));
+        CHECK(log == "2H");
+        CHECK(group.get_level(GPIONum(2)) == true);
+
+        for (uint32_t i = 0u; i < GPIODebounceGroup::SAMPLE_COUNT; i++)
+            sample_inputs(0u);
+        CHECK(log == "2H2L5L");
+    }
+
+    Mockgpio_Verify();
+    Mockesp_timer_Verify();
+}
+
+TEST_CASE("GPIODebounceGroup configures the pull resistors")
+{
+    CMOCK_SETUP();
+    g_gpio_configs.clear();
+    gpio_config_Stub(cmock_gpio_config_callback);
+    esp_timer_create_IgnoreAndReturn(ESP_OK);
+    esp_timer_start_periodic_IgnoreAndReturn(ESP_OK);
+    esp_timer_stop_IgnoreAndReturn(ESP_OK);
+    esp_timer_delete_IgnoreAndReturn(ESP_OK);
+    const std::array<GPIONum, 2> pins = {GPIONum(2), GPIONum(5)};
+
+    {
+        GPIODebounceGroup both(pins, [](GPIONum, bool) { }, std::chrono::milliseconds(1),
+                GPIOPullMode::PULLUP_PULLDOWN());
+        GPIODebounceGroup down(pins, [](GPIONum, bool) { }, std::chrono::milliseconds(1), GPIOPullMode::PULLDOWN());
+    }
+
+    REQUIRE(g_gpio_configs.size() == 2u);
+    CHECK(g_gpio_configs[0].pin_bit_mask == ((1ull << 2) | (1ull << 5)));
+    CHECK(g_gpio_configs[0].mode == GPIO_MODE_INPUT);
+    CHECK(g_gpio_configs[0].pull_up_en == GPIO_PULLUP_ENABLE);
+    CHECK(g_gpio_configs[0].pull_down_en == GPIO_PULLDOWN_ENABLE);
+    CHECK(g_gpio_configs[1].pull_up_en == GPIO_PULLUP_DISABLE);
+    CHECK(g_gpio_configs[1].pull_down_en == GPIO_PULLDOWN_ENABLE);
+}
+
+TEST_CASE("GPIODebounceGroup rejects a pin used twice")
+{
+    CMOCK_SETUP();
+    esp_timer_create_IgnoreAndReturn(ESP_OK);
+    esp_timer_stop_IgnoreAndReturn(ESP_OK);
+    esp_timer_delete_IgnoreAndReturn(ESP_OK);
+    const std::array<GPIONum, 2> pins = {GPIONum(2), GPIONum(2)};
+
+    CHECK_THROWS_AS(GPIODebounceGroup(pins, [](GPIONum, bool) { }), GPIOException&);
+}
+
+TEST_CASE("GPIONum make is checked at compile time")
+{
+    constexpr GPIONum num = GPIONum::make<18>();
+    static_assert(num.get_value() == 18u);
+    static_assert(is_valid_gpio_pin_num(18u));
+    static_assert(!is_valid_gpio_pin_num(24u));
+    static_assert(!is_valid_gpio_pin_num(GPIO_NUM_MAX));
+
+    CHECK(num == VALID_GPIO);
+}
+
+TEST_CASE("GPIOConfigBatch configures each group with one driver call")
+{
+    CMOCK_SETUP();
+    g_gpio_configs.clear();
+    gpio_config_Stub(cmock_gpio_config_callback);
+    gpio_set_level_ExpectAndReturn(GPIO_NUM_2, 1, ESP_OK);
+    GPIOConfigBatch batch;
+
+    batch.add_output(GPIONum(2)).add_output(GPIONum(4)).add_input(GPIONum(5), GPIOPullMode::PULLUP());
+    CHECK_THROWS_AS(batch.add_input(GPIONum(4)), GPIOException&);
+    CHECK_THROWS_AS(batch.output(GPIONum(2)), GPIOException&);
+    batch.apply();
+
+    REQUIRE(g_gpio_configs.size() == 2u);
+    CHECK(g_gpio_configs[0].pin_bit_mask == ((1ull << 2) | (1ull << 4)));
+    CHECK(g_gpio_configs[0].mode == GPIO_MODE_OUTPUT);
+    CHECK(g_gpio_configs[0].pull_up_en == GPIO_PULLUP_DISABLE);
+    CHECK(g_gpio_configs[0].pull_down_en == GPIO_PULLDOWN_DISABLE);
+    CHECK(g_gpio_configs[0].intr_type == GPIO_INTR_DISABLE);
+    CHECK(g_gpio_configs[1].pin_bit_mask == (1ull << 5));
+    CHECK(g_gpio_configs[1].mode == GPIO_MODE_INPUT);
+    CHECK(g_gpio_configs[1].pull_up_en == GPIO_PULLUP_ENABLE);
+    CHECK(g_gpio_configs[1].pull_down_en == GPIO_PULLDOWN_DISABLE);
+    CHECK(g_gpio_configs[1].intr_type == GPIO_INTR_DISABLE);
+
+    GPIO_Output output = batch.output(GPIONum(2));
+    output.set_high();
+    GPIOInput input = batch.input(GPIONum(5));
+    CHECK(input.get_num() == GPIONum(5));
+    CHECK_THROWS_AS(batch.input(GPIONum(4)), GPIOException&);
+    CHECK_THROWS_AS(batch.add_output(GPIONum(6)), GPIOException&);
+
+    Mockgpio_Verify();
+}
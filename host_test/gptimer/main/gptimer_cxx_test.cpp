@@ -0,0 +1,109 @@
+/*
+ * GpTimer C++ unit tests
+ *
+ * SPDX-License-Identifier: CC0
+ *
+ * This test code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#define CATCH_CONFIG_MAIN
+
+#include <stdio.h>
+#include <chrono>
+#include "esp_err.h"
+#include "gptimer_cxx.hpp"
+
+#include "catch.hpp"
+
+extern "C" {
+#include "Mockgptimer.h"
+}
+
+// TODO: IDF-2693, function definition just to satisfy linker, mock esp_common instead
+const char *esp_err_to_name(esp_err_t code) {
+    return "test";
+}
+
+using namespace std;
+using namespace idf;
+
+struct FixtureException : std::exception {
+    const char *what() const noexcept override {
+        return "CMock failed";
+    }
+};
+
+using MicrosecondClock = GpTimerClock<1000000u>;
+
+struct TimerFixture {
+    TimerFixture(uint32_t resolution) : handle(reinterpret_cast<gptimer_handle_t>(0xbeef)), resolution(resolution)
+    {
+        if (!TEST_PROTECT()) {
+            throw FixtureException();
+        }
+        gptimer_new_timer_ExpectAnyArgsAndReturn(ESP_OK);
+        gptimer_new_timer_ReturnThruPtr_ret_timer(&handle);
+        gptimer_get_resolution_ExpectAndReturn(handle, nullptr, ESP_OK);
+        gptimer_get_resolution_IgnoreArg_out_resolution();
+        gptimer_get_resolution_ReturnThruPtr_out_resolution(&this->resolution);
+        gptimer_del_timer_ExpectAndReturn(handle, ESP_OK);
+    }
+
+    ~TimerFixture()
+    {
+        Mockgptimer_Verify();
+    }
+
+    gptimer_handle_t handle;
+    uint32_t resolution;
+};
+
+TEST_CASE("GpTimerClock stays at the epoch until attached")
+{
+    TimerFixture fix(1000000u);
+    {
+        GpTimer timer(GPTIMER_COUNT_UP, 1000000u);
+
+        // No raw count is read, CMock fails on an unexpected call
+        CHECK(MicrosecondClock::now() == MicrosecondClock::time_point());
+        MicrosecondClock::attach(timer);
+        MicrosecondClock::detach();
+        CHECK(MicrosecondClock::now() == MicrosecondClock::time_point());
+    }
+}
+
+TEST_CASE("GpTimerClock attach rejects a timer with another resolution")
+{
+    TimerFixture fix(500000u);
+    {
+        GpTimer timer(GPTIMER_COUNT_UP, 500000u);
+
+        CHECK_THROWS_AS(MicrosecondClock::attach(timer), ESPException&);
+        CHECK(MicrosecondClock::now() == MicrosecondClock::time_point());
+    }
+}
+
+TEST_CASE("GpTimerClock now reads the raw count of the attached timer")
+{
+    TimerFixture fix(1000000u);
+    uint64_t count = 1234u;
+    {
+        GpTimer timer(GPTIMER_COUNT_UP, 1000000u);
+        MicrosecondClock::attach(timer);
+
+        gptimer_get_raw_count_ExpectAndReturn(fix.handle, nullptr, ESP_OK);
+        gptimer_get_raw_count_IgnoreArg_value();
+        gptimer_get_raw_count_ReturnThruPtr_value(&count);
+        MicrosecondClock::time_point now = MicrosecondClock::now();
+
+        CHECK(now.time_since_epoch().count() == 1234);
+        CHECK(chrono::duration_cast<chrono::microseconds>(now.time_since_epoch()) == chrono::microseconds(1234));
+
+        MicrosecondClock::detach();
+        CHECK(MicrosecondClock::now() == MicrosecondClock::time_point());
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ * LatestValue C++ unit tests
+ *
+ * SPDX-License-Identifier: CC0
+ *
+ * This test code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "latest_value_cxx.hpp"
+
+#include "catch.hpp"
+
+using namespace std;
+using namespace idf;
+
+namespace idf {
+
+/**
+ * Access to the write steps of LatestValue, to write in the middle of a read.
+ */
+struct LatestValueTest {
+    template <typename T>
+    static void setReadHook(LatestValue<T> & value, function<void()> hook)
+    {
+        value._readHook = hook;
+    }
+
+    template <typename T>
+    static uint32_t beginWrite(LatestValue<T> & value)
+    {
+        return value.beginWrite();
+    }
+
+    template <typename T>
+    static void storeWord(LatestValue<T> & value, size_t index, uint32_t word)
+    {
+        value._words[index].store(word, memory_order_relaxed);
+    }
+
+    template <typename T>
+    static void endWrite(LatestValue<T> & value, uint32_t sequence)
+    {
+        value.endWrite(sequence);
+    }
+};
+
+} // namespace idf
+
+namespace {
+
+struct Sample {
+    uint32_t count;
+    uint32_t check;
+};
+
+} // namespace
+
+TEST_CASE("LatestValue returns the initial value and the last write")
+{
+    LatestValue<Sample> mailbox(Sample{5, 6});
+    uint32_t version = 1u;
+
+    CHECK(mailbox.read(version).count == 5u);
+    CHECK(version == 0u);
+
+    mailbox.write(Sample{7, 8});
+    bool woken = false;
+    mailbox.writeFromISR(Sample{9, 10}, woken);
+
+    Sample sample = mailbox.read(version);
+    CHECK(sample.count == 9u);
+    CHECK(sample.check == 10u);
+    CHECK(version == 2u);
+    CHECK(mailbox.version() == 2u);
+}
+
+TEST_CASE("LatestValue waitForChange")
+{
+    LatestValue<int> mailbox;
+    uint32_t version = mailbox.version();
+
+    CHECK_FALSE(mailbox.waitForChange(version, 0).has_value());
+    CHECK_FALSE(mailbox.waitForChange(version, pdMS_TO_TICKS(10)).has_value());
+
+    mailbox.write(3);
+    CHECK(mailbox.waitForChange(version, 0) == 3);
+    CHECK(version == 1u);
+}
+
+TEST_CASE("LatestValue read retries while a write is in progress")
+{
+    LatestValue<Sample> mailbox(Sample{1, ~1u});
+    uint32_t attempts = 0u;
+    uint32_t sequence = 0u;
+
+    LatestValueTest::setReadHook(mailbox, [&]() {
+        attempts++;
+        if (attempts == 1u) {
+            // The write starts after the reader loaded the sequence, and only the first word is stored before
+            // the copy: the copied value is torn
+            sequence = LatestValueTest::beginWrite(mailbox);
+            LatestValueTest::storeWord(mailbox, 0u, 2u);
+        } else if (attempts == 2u) {
+            // The reader loaded the odd sequence and must not copy
+            LatestValueTest::storeWord(mailbox, 1u, ~2u);
+            LatestValueTest::endWrite(mailbox, sequence);
+        }
+    });
+
+    uint32_t version = 0u;
+    Sample sample = mailbox.read(version);
+
+    CHECK(attempts == 3u);
+    CHECK(sample.count == 2u);
+    CHECK(sample.check == ~2u);
+    CHECK(version == 1u);
+}
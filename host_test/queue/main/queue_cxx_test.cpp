@@ -0,0 +1,207 @@
+/*
+ * Queue C++ unit tests
+ *
+ * SPDX-License-Identifier: CC0
+ *
+ * This test code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#define CATCH_CONFIG_RUNNER
+
+#include <stdio.h>
+#include <array>
+#include <cstdlib>
+#include <chrono>
+#include <numeric>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "queue_cxx.hpp"
+
+#include "catch.hpp"
+
+using namespace std;
+using namespace idf;
+
+namespace {
+
+constexpr size_t BURST = 32u;
+constexpr size_t BURST_COUNT = 2000u;
+
+struct Producer {
+    Queue<uint32_t> & queue;
+    bool batched;
+    SemaphoreHandle_t done;
+};
+
+void producer_task(void * arg)
+{
+    Producer * producer = static_cast<Producer *>(arg);
+    array<uint32_t, BURST> burst;
+    uint32_t next = 0u;
+    for (size_t i = 0u; i < BURST_COUNT; i++) {
+        iota(burst.begin(), burst.end(), next);
+        next += BURST;
+        if (producer->batched) {
+            size_t sent = 0u;
+            while (sent < burst.size())
+                sent += producer->queue.sendN(span(burst).subspan(sent), portMAX_DELAY);
+        } else {
+            for (uint32_t value : burst)
+                producer->queue.send(value, portMAX_DELAY);
+        }
+    }
+    xSemaphoreGive(producer->done);
+    vTaskDelete(nullptr);
+}
+
+struct BenchResult {
+    size_t receiveCalls;
+    // Receive calls which found the queue empty, so the consumer blocked and was woken by the producer
+    size_t wakeups;
+    chrono::microseconds duration;
+    bool inOrder;
+};
+
+BenchResult run_transfer(bool batched)
+{
+    Queue<uint32_t> queue(BURST);
+    Producer producer{queue, batched, xSemaphoreCreateBinary()};
+    BenchResult result{0u, 0u, {}, true};
+
+    auto start = chrono::steady_clock::now();
+    xTaskCreate(producer_task, "producer", 4096, &producer, uxTaskPriorityGet(nullptr), nullptr);
+    uint32_t expected = 0u;
+    array<uint32_t, BURST> items;
+    while (expected < BURST * BURST_COUNT) {
+        size_t count = 1u;
+        if (queue.messagesWaiting() == 0u)
+            result.wakeups++;
+        if (batched) {
+            count = queue.receiveN(items, 1u, portMAX_DELAY);
+        } else {
+            items[0] = queue.receive(portMAX_DELAY).value();
+        }
+        result.receiveCalls++;
+        for (size_t i = 0u; i < count; i++)
+            result.inOrder = result.inOrder && items[i] == expected++;
+    }
+    result.duration = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+    xSemaphoreTake(producer.done, portMAX_DELAY);
+    vSemaphoreDelete(producer.done);
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("Queue sendN posts all items if there is room")
+{
+    Queue<int> queue(4);
+    const array<int, 3> items = {1, 2, 3};
+
+    CHECK(queue.sendN(items, 0) == 3u);
+    CHECK(queue.messagesWaiting() == 3u);
+    CHECK(queue.receive(0) == 1);
+    CHECK(queue.receive(0) == 2);
+    CHECK(queue.receive(0) == 3);
+}
+
+TEST_CASE("Queue sendN stops when the queue is full")
+{
+    Queue<int> queue(2);
+    const array<int, 3> items = {1, 2, 3};
+
+    CHECK(queue.sendN(items, 0) == 2u);
+    CHECK(queue.sendN(items, 0) == 0u);
+    CHECK(queue.sendN(span<const int>(), 0) == 0u);
+}
+
+TEST_CASE("Queue receiveN with min 0 does not block")
+{
+    Queue<int> queue(4);
+    array<int, 4> items = {};
+
+    CHECK(queue.receiveN(items, 0u, portMAX_DELAY) == 0u);
+
+    queue.send(7, 0);
+    queue.send(8, 0);
+    CHECK(queue.receiveN(items, 0u, portMAX_DELAY) == 2u);
+    CHECK(items[0] == 7);
+    CHECK(items[1] == 8);
+}
+
+TEST_CASE("Queue receiveN returns at most the span size")
+{
+    Queue<int> queue(4);
+    const array<int, 4> sent = {1, 2, 3, 4};
+    array<int, 3> items = {};
+
+    queue.sendN(sent, 0);
+    CHECK(queue.receiveN(items, 1u, 0) == 3u);
+    CHECK(items == array<int, 3>{1, 2, 3});
+    CHECK(queue.messagesWaiting() == 1u);
+}
+
+TEST_CASE("Queue receiveN times out with the items already received")
+{
+    Queue<int> queue(4);
+    array<int, 4> items = {};
+
+    queue.send(5, 0);
+    CHECK(queue.receiveN(items, 3u, pdMS_TO_TICKS(20)) == 1u);
+    CHECK(items[0] == 5);
+}
+
+TEST_CASE("Queue ISR batch functions")
+{
+    Queue<int> queue(3);
+    const array<int, 4> sent = {1, 2, 3, 4};
+    array<int, 4> items = {};
+    bool woken = false;
+
+    CHECK(queue.sendNFromISR(sent, woken) == 3u);
+    CHECK(queue.receiveNFromISR(items, &woken) == 3u);
+    CHECK(items[2] == 3);
+    CHECK_FALSE(woken);
+}
+
+TEST_CASE("Queue overwrite replaces the item")
+{
+    Queue<int> queue(1);
+    bool woken = false;
+
+    queue.overwrite(1);
+    queue.overwrite(2);
+    CHECK(queue.peek(0) == 2);
+    queue.overwriteFromISR(3, woken);
+    CHECK(queue.receive(0) == 3);
+}
+
+TEST_CASE("Queue batched transfer benchmark")
+{
+    BenchResult single = run_transfer(false);
+    BenchResult batched = run_transfer(true);
+
+    CHECK(single.inOrder);
+    CHECK(batched.inOrder);
+
+    printf("Queue transfer of %zu items in bursts of %zu:\n", BURST * BURST_COUNT, BURST);
+    printf("  send/receive:   %zu receive calls, %zu consumer wake-ups (%.2f per burst), %lld us\n",
+           single.receiveCalls, single.wakeups, static_cast<double>(single.wakeups) / BURST_COUNT,
+           static_cast<long long>(single.duration.count()));
+    printf("  sendN/receiveN: %zu receive calls, %zu consumer wake-ups (%.2f per burst), %lld us\n",
+           batched.receiveCalls, batched.wakeups, static_cast<double>(batched.wakeups) / BURST_COUNT,
+           static_cast<long long>(batched.duration.count()));
+}
+
+extern "C" void app_main(void)
+{
+    int argc = 1;
+    const char *argv[2] = {"test_queue_cxx_host", nullptr};
+    int result = Catch::Session().run(argc, argv);
+    exit(result);
+}
@@ -0,0 +1,79 @@
+/*
+ * QueueSet C++ unit tests
+ *
+ * SPDX-License-Identifier: CC0
+ *
+ * This test code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "queue_set_cxx.hpp"
+
+#include "catch.hpp"
+
+using namespace std;
+using namespace idf;
+
+namespace {
+
+struct Command {
+    int id;
+};
+
+} // namespace
+
+TEST_CASE("QueueSet select returns the ready queue")
+{
+    Queue<int> numbers(2);
+    Queue<Command> commands(2);
+    QueueSet<int, Command> set(numbers, commands);
+
+    CHECK_FALSE(set.select(0).has_value());
+
+    commands.send(Command{3}, 0);
+    CHECK(set.select(0) == 1u);
+    CHECK(commands.receive(0)->id == 3);
+
+    numbers.send(4, 0);
+    CHECK(set.select(0) == 0u);
+    CHECK(numbers.receive(0) == 4);
+}
+
+TEST_CASE("QueueSet receive visits items in posting order")
+{
+    Queue<int> numbers(2);
+    Queue<Command> commands(2);
+    QueueSet<int, Command> set(numbers, commands);
+    struct Visitor {
+        string log;
+        void operator()(int value) { log += "n" + to_string(value); }
+        void operator()(const Command & command) { log += "c" + to_string(command.id); }
+    } visitor;
+
+    numbers.send(1, 0);
+    commands.send(Command{2}, 0);
+    numbers.send(3, 0);
+
+    while (set.receive(visitor, 0)) { }
+
+    CHECK(visitor.log == "n1c2n3");
+}
+
+TEST_CASE("QueueSet rejects a non empty queue")
+{
+    Queue<int> numbers(2);
+    Queue<Command> commands(2);
+
+    commands.send(Command{1}, 0);
+
+    CHECK_THROWS_AS((QueueSet<int, Command>(numbers, commands)), ESPException&);
+
+    // numbers was released from the failed set and can join a new one
+    commands.receive(0);
+    QueueSet<int, Command> set(numbers, commands);
+}
@@ -0,0 +1,156 @@
+/*
+ * SpscRing C++ unit tests
+ *
+ * SPDX-License-Identifier: CC0
+ *
+ * This test code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <stdio.h>
+#include <chrono>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "queue_cxx.hpp"
+#include "spsc_ring_cxx.hpp"
+
+#include "catch.hpp"
+
+using namespace std;
+using namespace idf;
+
+namespace {
+
+constexpr uint32_t STRESS_ITEMS = 1000000u;
+
+template <typename Channel>
+struct StressProducer {
+    Channel & channel;
+    SemaphoreHandle_t done;
+};
+
+bool push(SpscRing<uint32_t, 64> & ring, uint32_t value)
+{
+    bool woken = false;
+    // Alternate both producer paths
+    return (value & 1u) ? ring.pushFromISR(value, woken) : ring.push(value);
+}
+
+bool push(Queue<uint32_t> & queue, uint32_t value)
+{
+    return queue.send(value, portMAX_DELAY);
+}
+
+optional<uint32_t> pop(SpscRing<uint32_t, 64> & ring)
+{
+    return ring.pop(portMAX_DELAY);
+}
+
+optional<uint32_t> pop(Queue<uint32_t> & queue)
+{
+    return queue.receive(portMAX_DELAY);
+}
+
+template <typename Channel>
+void stress_producer_task(void * arg)
+{
+    StressProducer<Channel> * producer = static_cast<StressProducer<Channel> *>(arg);
+    for (uint32_t value = 0u; value < STRESS_ITEMS;) {
+        if (push(producer->channel, value))
+            value++;
+        else
+            taskYIELD();
+    }
+    xSemaphoreGive(producer->done);
+    vTaskDelete(nullptr);
+}
+
+/**
+ * Transfer STRESS_ITEMS from a producer task to the current task.
+ * @return the duration, or a negative duration if an item was lost or out of order
+ */
+template <typename Channel>
+chrono::microseconds run_stress(Channel & channel)
+{
+    StressProducer<Channel> producer{channel, xSemaphoreCreateBinary()};
+    bool inOrder = true;
+
+    auto start = chrono::steady_clock::now();
+    xTaskCreate(stress_producer_task<Channel>, "producer", 4096, &producer, uxTaskPriorityGet(nullptr), nullptr);
+    for (uint32_t expected = 0u; expected < STRESS_ITEMS; expected++) {
+        optional<uint32_t> value = pop(channel);
+        inOrder = inOrder && value == expected;
+    }
+    auto duration = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+    xSemaphoreTake(producer.done, portMAX_DELAY);
+    vSemaphoreDelete(producer.done);
+    return inOrder ? duration : chrono::microseconds(-1);
+}
+
+} // namespace
+
+TEST_CASE("SpscRing push and pop in order")
+{
+    SpscRing<int, 4> ring;
+
+    CHECK(ring.empty());
+    CHECK(ring.push(1));
+    CHECK(ring.push(2));
+    CHECK(ring.size() == 2u);
+    CHECK(ring.pop(0) == 1);
+    CHECK(ring.popFromISR() == 2);
+    CHECK(ring.empty());
+}
+
+TEST_CASE("SpscRing push fails when full")
+{
+    SpscRing<int, 2> ring;
+    bool woken = false;
+
+    CHECK(ring.push(1));
+    CHECK(ring.pushFromISR(2, woken));
+    CHECK_FALSE(ring.push(3));
+    CHECK_FALSE(ring.pushFromISR(3, woken));
+    CHECK_FALSE(woken);
+    CHECK(ring.pop(0) == 1);
+    CHECK(ring.push(3));
+}
+
+TEST_CASE("SpscRing indexes wrap around")
+{
+    SpscRing<uint32_t, 4> ring;
+
+    for (uint32_t i = 0u; i < 100u; i++) {
+        CHECK(ring.push(i));
+        CHECK(ring.pop(0) == i);
+    }
+}
+
+TEST_CASE("SpscRing pop times out when empty")
+{
+    SpscRing<int, 4> ring;
+
+    CHECK_FALSE(ring.pop(0).has_value());
+    CHECK_FALSE(ring.pop(pdMS_TO_TICKS(20)).has_value());
+}
+
+TEST_CASE("SpscRing multitask stress and benchmark against Queue")
+{
+    static SpscRing<uint32_t, 64> ring;
+    Queue<uint32_t> queue(64);
+
+    chrono::microseconds ringDuration = run_stress(ring);
+    chrono::microseconds queueDuration = run_stress(queue);
+
+    CHECK(ringDuration.count() >= 0);
+    CHECK(queueDuration.count() >= 0);
+    CHECK(ring.empty());
+
+    printf("Transfer of %u items between two tasks:\n", STRESS_ITEMS);
+    printf("  SpscRing: %lld us\n", static_cast<long long>(ringDuration.count()));
+    printf("  Queue:    %lld us\n", static_cast<long long>(queueDuration.count()));
+}
@@ -0,0 +1,91 @@
+/*
+ * StreamBuffer and MessageBuffer C++ unit tests
+ *
+ * SPDX-License-Identifier: CC0
+ *
+ * This test code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <array>
+#include "freertos/FreeRTOS.h"
+#include "stream_buffer_cxx.hpp"
+
+#include "catch.hpp"
+
+using namespace std;
+using namespace idf;
+
+TEST_CASE("StreamBuffer transfers bytes")
+{
+    StreamBuffer stream(8);
+    const array<uint8_t, 5> sent = {1, 2, 3, 4, 5};
+    array<uint8_t, 4> received = {};
+
+    CHECK(stream.isEmpty());
+    CHECK(stream.send(sent, 0) == 5u);
+    CHECK(stream.bytesAvailable() == 5u);
+    CHECK(stream.receive(received, 0) == 4u);
+    CHECK(received == array<uint8_t, 4>{1, 2, 3, 4});
+    CHECK(stream.receive(received, 0) == 1u);
+    CHECK(received[0] == 5u);
+}
+
+TEST_CASE("StreamBuffer partial send when full")
+{
+    StaticStreamBuffer<4> stream;
+    const array<uint8_t, 6> sent = {1, 2, 3, 4, 5, 6};
+
+    CHECK(stream.send(sent, 0) == 4u);
+    CHECK(stream.isFull());
+    CHECK(stream.reset());
+    CHECK(stream.isEmpty());
+}
+
+TEST_CASE("StreamBuffer trigger level")
+{
+    StaticStreamBuffer<16> stream(4);
+    const array<uint8_t, 2> sent = {1, 2};
+    array<uint8_t, 16> received = {};
+
+    stream.send(sent, 0);
+    // Below the trigger level a blocking receive times out with the available bytes
+    CHECK(stream.receive(received, pdMS_TO_TICKS(10)) == 2u);
+
+    stream.setTriggerLevel(2);
+    CHECK_THROWS_AS(stream.setTriggerLevel(32), ESPException&);
+}
+
+TEST_CASE("MessageBuffer keeps message boundaries")
+{
+    StaticMessageBuffer<32> messages;
+    const array<uint8_t, 3> first = {1, 2, 3};
+    const array<uint8_t, 1> second = {4};
+    array<uint8_t, 8> received = {};
+
+    CHECK(messages.send(first, 0));
+    CHECK(messages.send(second, 0));
+    CHECK(messages.nextLengthBytes() == 3u);
+    CHECK(messages.receive(received, 0) == 3u);
+    CHECK(messages.receive(received, 0) == 1u);
+    CHECK(received[0] == 4u);
+    CHECK(messages.isEmpty());
+}
+
+TEST_CASE("MessageBuffer rejects a message bigger than the space")
+{
+    MessageBuffer messages(8);
+    const array<uint8_t, 8> big = {};
+    array<uint8_t, 2> small = {};
+
+    CHECK_FALSE(messages.send(big, 0));
+
+    const array<uint8_t, 3> sent = {1, 2, 3};
+    CHECK(messages.send(sent, 0));
+    // The message stays in the buffer if the receive buffer is too small
+    CHECK(messages.receive(small, 0) == 0u);
+    CHECK(messages.nextLengthBytes() == 3u);
+}
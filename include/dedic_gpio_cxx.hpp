@@ -0,0 +1,103 @@
+#pragma once
+
+#if __cpp_exceptions
+
+#include "sdkconfig.h"
+#include "gpio_cxx.hpp"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "soc/soc_caps.h"
+#endif
+
+#if SOC_DEDICATED_GPIO_SUPPORTED
+
+#include "driver/dedic_gpio.h"
+#include "hal/dedic_gpio_cpu_ll.h"
+#include <cstdint>
+#include <span>
+
+namespace idf {
+
+/**
+ * @brief A bundle of GPIOs driven directly by CPU instructions through the dedicated GPIO channels.
+ *
+ * Writing or reading the bundle takes a few CPU cycles, without any driver call nor peripheral bus access, which
+ * allows bit-banging protocols with a cycle accurate timing.
+ *
+ * Bit i of the masks and values matches the GPIO i given to the constructor.
+ *
+ * @warning The dedicated GPIO channels belong to a CPU core, the bundle must only be written and read from the core
+ *          which created it. Pin the task using it to this core.
+ */
+class DedicatedGPIOBundle {
+public:
+    enum class Mode {INPUT, OUTPUT, INPUT_OUTPUT};
+
+    /**
+     * @brief Configure the GPIOs and bind them to dedicated GPIO channels of the current core.
+     *
+     * @param pins The GPIOs of the bundle, at most SOC_DEDIC_GPIO_OUT_CHANNELS_NUM for an output bundle and
+     *        SOC_DEDIC_GPIO_IN_CHANNELS_NUM for an input bundle.
+     * @param mode The direction of the GPIOs.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_ARG if there are no pins
+     *              - ESP_ERR_NOT_FOUND if there are not enough free consecutive channels
+     *              - if the underlying driver function fails
+     */
+    DedicatedGPIOBundle(std::span<const GPIONum> pins, Mode mode = Mode::OUTPUT);
+
+    /**
+     * @brief Release the channels, the GPIOs keep their configuration.
+     */
+    ~DedicatedGPIOBundle();
+
+    /**
+     * @brief Set the level of the GPIOs selected by a mask, the others are not modified.
+     *
+     * All the selected GPIOs change at the same time.
+     */
+    inline void write(uint32_t mask, uint32_t value) noexcept
+    {
+        dedic_gpio_cpu_ll_write_mask((mask << _out_offset) & _out_mask, value << _out_offset);
+    }
+
+    /**
+     * @brief Set the level of all the GPIOs.
+     */
+    inline void write(uint32_t value) noexcept
+    {
+        dedic_gpio_cpu_ll_write_mask(_out_mask, value << _out_offset);
+    }
+
+    /**
+     * @brief Return the input levels of the GPIOs.
+     */
+    inline uint32_t read() const noexcept
+    {
+        return (dedic_gpio_cpu_ll_read_in() & _in_mask) >> _in_offset;
+    }
+
+    /**
+     * @brief Return the output levels of the GPIOs, as last written.
+     */
+    inline uint32_t read_output() const noexcept
+    {
+        return (dedic_gpio_cpu_ll_read_out() & _out_mask) >> _out_offset;
+    }
+
+private:
+    DedicatedGPIOBundle(const DedicatedGPIOBundle &) = delete;
+    DedicatedGPIOBundle & operator=(const DedicatedGPIOBundle &) = delete;
+
+    dedic_gpio_bundle_handle_t _handle;
+    uint32_t _out_mask;
+    uint32_t _out_offset;
+    uint32_t _in_mask;
+    uint32_t _in_offset;
+};
+
+} // idf
+
+#endif // SOC_DEDICATED_GPIO_SUPPORTED
+
+#endif
@@ -6,12 +6,25 @@
 
 #pragma once
 
+#include <cstdint>
+#include "sdkconfig.h"
 #include "esp_event.h"
 
+#if CONFIG_IDF_TARGET_LINUX
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
 namespace idf {
 
 namespace event {
 
+struct ESPEventBatchItem;
+
 /**
  * Abstract interface for direct calls to esp_event C-API.
  * This is generally not intended to be used directly.
@@ -38,6 +51,14 @@ public:
             void* event_data,
             size_t event_data_size,
             TickType_t ticks_to_wait) = 0;
+
+    /**
+     * Post several events in order. The esp_event C-API has no batch posting, so by default the events are posted one
+     * by one with post(), each waiting up to ticks_to_wait, and posting stops at the first failure.
+     */
+    virtual esp_err_t post_batch(const ESPEventBatchItem *items,
+            size_t count,
+            TickType_t ticks_to_wait);
 };
 
 /**
@@ -120,6 +141,121 @@ private:
     esp_event_loop_handle_t event_loop;
 };
 
+#if CONFIG_IDF_TARGET_LINUX
+/**
+ * @brief Portable API version running its own event loop with a thread and a queue.
+ *
+ * It only uses the types of the esp_event component, not its functions. It is only built for the linux target, where
+ * it is the default API of ESPEventLoop.
+ * The behavior follows the esp_event loops: the event data is copied when posting, a handler may be registered for
+ * ESP_EVENT_ANY_ID of a base or for ESP_EVENT_ANY_BASE and ESP_EVENT_ANY_ID, and unregistering a handler from another
+ * thread waits for the end of the handler in progress. The handlers of an event are called in the order of their
+ * registration, from the thread of the loop.
+ */
+class ESPEventAPIHost : public ESPEventAPI {
+public:
+    /**
+     * @param queue_size the maximum number of posted events waiting to be dispatched.
+     *
+     * @throws EventException with error ESP_ERR_INVALID_ARG if queue_size is 0.
+     */
+    ESPEventAPIHost(size_t queue_size = 32);
+
+    /**
+     * Stop the loop thread, the pending events are dropped.
+     *
+     * @note Must not be called from an event handler of this loop.
+     */
+    virtual ~ESPEventAPIHost();
+
+    /**
+     * Copying would lead to stopping the event loop through destructor.
+     */
+    ESPEventAPIHost(const ESPEventAPIHost &o) = delete;
+    ESPEventAPIHost& operator=(const ESPEventAPIHost&) = delete;
+
+    esp_err_t handler_register(esp_event_base_t event_base,
+            int32_t event_id,
+            esp_event_handler_t event_handler,
+            void* event_handler_arg,
+            esp_event_handler_instance_t *instance) override;
+
+    esp_err_t handler_unregister(esp_event_base_t event_base,
+            int32_t event_id,
+            esp_event_handler_instance_t instance) override;
+
+    esp_err_t post(esp_event_base_t event_base,
+            int32_t event_id,
+            void* event_data,
+            size_t event_data_size,
+            TickType_t ticks_to_wait) override;
+
+    /**
+     * Queue all the events at once, after waiting for room for all of them, and wake up the loop once.
+     *
+     * @return ESP_ERR_INVALID_SIZE if count is greater than the queue size, the other errors are those of post().
+     */
+    esp_err_t post_batch(const ESPEventBatchItem *items,
+            size_t count,
+            TickType_t ticks_to_wait) override;
+
+private:
+    struct Handler {
+        esp_event_base_t base;
+        int32_t id;
+        esp_event_handler_t handler;
+        void *arg;
+    };
+
+    struct Event {
+        esp_event_base_t base;
+        int32_t id;
+        std::vector<uint8_t> data;
+    };
+
+    /**
+     * Wait until the queue has room for count events, with queue_mutex locked.
+     */
+    esp_err_t wait_for_room(std::unique_lock<std::mutex> &lock, size_t count, TickType_t ticks_to_wait);
+
+    /**
+     * Body of the loop thread.
+     */
+    void run();
+
+    /**
+     * Call the handlers of an event, with handlers_mutex locked.
+     */
+    void dispatch(Event &event);
+
+    const size_t queue_size;
+
+    /**
+     * Protects events and stopping.
+     */
+    std::mutex queue_mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<Event> events;
+    bool stopping;
+
+    /**
+     * Protects handlers, locked during a whole dispatch so that a handler can't be unregistered while it runs. It is
+     * recursive so that the handlers can register and unregister handlers.
+     */
+    std::recursive_mutex handlers_mutex;
+
+    /**
+     * A list so that the handlers keep their address, which is their instance handle.
+     * During a dispatch, unregistered handlers get a null handler and are erased at its end.
+     */
+    std::list<Handler> handlers;
+    bool dispatching;
+
+    std::thread thread;
+};
+#endif // CONFIG_IDF_TARGET_LINUX
+
 } // event
 
 } // idf
@@ -18,6 +18,12 @@
 #include <thread>
 #include <atomic>
 #include <iostream>
+#include <array>
+#include <new>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include "sdkconfig.h"
 #include "esp_timer.h"
 #include "esp_err.h"
 #include "esp_log.h"
@@ -167,6 +173,13 @@ protected:
      */
     virtual void dispatch_event_handling(ESPEvent event, void *event_data);
 
+    /**
+     * Unregister the event handler, nothing is done if it is already unregistered.
+     *
+     * After it returns, the event loop doesn't run the handler anymore.
+     */
+    void unregister();
+
     /**
      * Save the event here to be able to un-register from the event loop on destruction.
      */
@@ -179,7 +192,7 @@ protected:
     std::shared_ptr<ESPEventAPI> api;
 
     /**
-     * Event handler instance from the esp event C API.
+     * Event handler instance from the esp event C API, null once unregistered.
      */
     esp_event_handler_instance_t instance;
 };
@@ -249,6 +262,499 @@ protected:
     std::mutex timeout_mutex;
 };
 
+/**
+ * Event whose data has the type T.
+ *
+ * Its handlers, registered with ESPEventLoop::register_event(), receive the data as a \c const T& instead of a
+ * \c void*, and it is posted with ESPEventLoop::post_event(). As with post_event_data(), the data is copied into the
+ * event loop queue, so T must be trivially copyable. Use ESPPooledEvent for large data.
+ */
+template<typename T>
+struct ESPTypedEvent : public ESPEvent {
+    static_assert(std::is_trivially_copyable_v<T>, "ESPTypedEvent data is copied, use ESPPooledEvent instead");
+
+    using DataType = T;
+    using Handler = std::function<void(const ESPEvent &, const T &)>;
+
+    ESPTypedEvent(esp_event_base_t event_base, const ESPEventID &event_id)
+        : ESPEvent(event_base, event_id) { }
+};
+
+/**
+ * An event and its data, to post several events at once with ESPEventLoop::post_batch().
+ *
+ * Only a pointer to the data is kept, so the data must stay valid until post_batch() returns.
+ */
+struct ESPEventBatchItem {
+    explicit ESPEventBatchItem(const ESPEvent &event)
+        : event(event), data(nullptr), data_size(0) { }
+
+    template<typename T>
+    ESPEventBatchItem(const ESPEvent &event, const T &event_data)
+        : event(event), data(&event_data), data_size(sizeof(T)) { }
+
+    /**
+     * A temporary would be destroyed before post_batch() is called.
+     */
+    template<typename T>
+    ESPEventBatchItem(const ESPEvent &event, const T &&event_data) = delete;
+
+    ESPEvent event;
+    const void *data;
+    size_t data_size;
+};
+
+template<typename T, std::size_t PoolSize>
+class ESPPooledEventReg;
+
+/**
+ * Event whose data of type T is passed by pointer from a pool of PoolSize preallocated slots.
+ *
+ * The data is constructed in a slot with acquire() and posted with ESPEventLoop::post_event(), only a pointer
+ * to the slot goes through the event loop queue. The slot is reference counted: each handler registered with
+ * ESPEventLoop::register_event() when the event is posted holds a reference, released after it returns or when it
+ * is unregistered, and the slot is freed once all the references are released.
+ *
+ * @note The event keeps the state of its pool and handlers, so it must outlive them, and it must be used with a
+ *       single event loop.
+ * @note If no handler is registered when the event is posted, the data is freed without posting anything.
+ */
+template<typename T, std::size_t PoolSize>
+class ESPPooledEvent {
+    static_assert(PoolSize > 0, "ESPPooledEvent needs at least one slot");
+
+    enum class SlotState {FREE, ACQUIRED, POSTED};
+
+    struct Slot {
+        T &value() noexcept
+        {
+            return *std::launder(reinterpret_cast<T*>(storage));
+        }
+
+        alignas(T) unsigned char storage[sizeof(T)];
+        SlotState state;
+
+        /**
+         * True while the poster holds a reference.
+         */
+        bool posting;
+
+        /**
+         * One bit per handler holding a reference.
+         */
+        uint32_t pending;
+    };
+
+public:
+    /**
+     * Maximum number of handlers registered at the same time.
+     */
+    static constexpr std::size_t MAX_HANDLERS = 32;
+
+    using DataType = T;
+    using Handler = std::function<void(const ESPEvent &, const T &)>;
+
+    /**
+     * Data in a slot of the pool, owned by the poster until it is posted.
+     *
+     * The slot is freed if the data is destroyed without being posted.
+     */
+    class Data {
+    public:
+        Data(Data &&other) noexcept : event(other.event), slot(other.slot)
+        {
+            other.slot = nullptr;
+        }
+
+        ~Data()
+        {
+            if (slot != nullptr) {
+                std::lock_guard<std::mutex> lock(event->pool_mutex);
+                event->free(*slot);
+            }
+        }
+
+        T &operator*() const noexcept
+        {
+            return slot->value();
+        }
+
+        T *operator->() const noexcept
+        {
+            return &slot->value();
+        }
+
+    private:
+        Data(ESPPooledEvent &event, Slot &slot) : event(&event), slot(&slot) { }
+
+        Data(const Data&) = delete;
+        Data &operator=(const Data&) = delete;
+        Data &operator=(Data&&) = delete;
+
+        friend class ESPPooledEvent;
+
+        ESPPooledEvent *event;
+        Slot *slot;
+    };
+
+    ESPPooledEvent(esp_event_base_t event_base, const ESPEventID &event_id)
+        : event(event_base, event_id), pool_mutex(), slots(), handler_bits(0) { }
+
+    ESPPooledEvent(const ESPPooledEvent&) = delete;
+    ESPPooledEvent &operator=(const ESPPooledEvent&) = delete;
+
+    /**
+     * Construct the data of an event in a free slot of the pool.
+     *
+     * @param args the arguments of the constructor of T.
+     *
+     * @throws EventException with error ESP_ERR_NO_MEM if all the slots are in use.
+     */
+    template<typename... Args>
+    Data acquire(Args&&... args)
+    {
+        Slot *slot = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            for (Slot &candidate : slots) {
+                if (candidate.state == SlotState::FREE) {
+                    candidate.state = SlotState::ACQUIRED;
+                    slot = &candidate;
+                    break;
+                }
+            }
+        }
+        if (slot == nullptr) {
+            throw EventException(ESP_ERR_NO_MEM);
+        }
+
+        try {
+            new (slot->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            slot->state = SlotState::FREE;
+            throw;
+        }
+        return Data(*this, *slot);
+    }
+
+    /**
+     * Return the number of free slots.
+     */
+    std::size_t available() const
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        std::size_t count = 0;
+        for (const Slot &slot : slots) {
+            if (slot.state == SlotState::FREE) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    const ESPEvent &get_event() const noexcept
+    {
+        return event;
+    }
+
+private:
+    friend class ESPEventLoop;
+    friend class ESPPooledEventReg<T, PoolSize>;
+
+    /**
+     * Destroy the data of a slot and make it available, with pool_mutex locked.
+     */
+    void free(Slot &slot) noexcept
+    {
+        slot.value().~T();
+        slot.state = SlotState::FREE;
+    }
+
+    /**
+     * Release the references of some handlers on a posted slot, with pool_mutex locked.
+     */
+    void release(Slot &slot, uint32_t handlers) noexcept
+    {
+        slot.pending &= ~handlers;
+        if (slot.pending == 0 && !slot.posting) {
+            free(slot);
+        }
+    }
+
+    /**
+     * Take the slot from the data before posting it, with a reference for each registered handler and one for the
+     * poster, return null if no handler is registered.
+     */
+    Slot *prepare_post(Data &data) noexcept
+    {
+        Slot *slot = data.slot;
+        data.slot = nullptr;
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (handler_bits == 0) {
+            free(*slot);
+            return nullptr;
+        }
+        slot->state = SlotState::POSTED;
+        slot->posting = true;
+        slot->pending = handler_bits;
+        return slot;
+    }
+
+    /**
+     * Release the reference of the poster. A slot which could not be posted is never dispatched, so it is freed.
+     */
+    void finish_post(Slot &slot, bool posted) noexcept
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        slot.posting = false;
+        release(slot, posted ? 0 : slot.pending);
+    }
+
+    const ESPEvent event;
+
+    /**
+     * Protects the slots and handler_bits.
+     */
+    mutable std::mutex pool_mutex;
+    std::array<Slot, PoolSize> slots;
+
+    /**
+     * One bit per registered handler.
+     */
+    uint32_t handler_bits;
+};
+
+/**
+ * Registration of a handler of an ESPPooledEvent, obtained with ESPEventLoop::register_event().
+ *
+ * The handler only gets the events posted after the end of its registration. On destruction, the references the
+ * handler holds on the slots it didn't handle yet are released.
+ */
+template<typename T, std::size_t PoolSize>
+class ESPPooledEventReg : public ESPEventReg {
+    using Event = ESPPooledEvent<T, PoolSize>;
+    using Slot = typename Event::Slot;
+
+    /**
+     * State shared with the handler registered in the event loop, which can be called before the end of the
+     * constructor.
+     */
+    struct State {
+        Event &event;
+        typename Event::Handler cb;
+
+        /**
+         * Bit of the handler in the references of the slots, 0 until the end of the registration.
+         */
+        uint32_t bit;
+
+        void dispatch(const ESPEvent &event_id, void *event_data)
+        {
+            Slot &slot = **static_cast<Slot**>(event_data);
+            {
+                std::lock_guard<std::mutex> lock(event.pool_mutex);
+                if ((slot.pending & bit) == 0) {
+                    // Posted before the end of the registration, this handler holds no reference on the slot
+                    return;
+                }
+            }
+
+            cb(event_id, slot.value());
+
+            std::lock_guard<std::mutex> lock(event.pool_mutex);
+            event.release(slot, bit);
+        }
+    };
+
+public:
+    /**
+     * @throws EventException
+     *              - ESP_ERR_INVALID_ARG if cb or api are null
+     *              - ESP_ERR_NO_MEM if MAX_HANDLERS handlers are already registered
+     * @throws ESPEventRegisterException if the registration fails.
+     */
+    ESPPooledEventReg(typename Event::Handler cb, Event &event, std::shared_ptr<ESPEventAPI> api)
+        : ESPPooledEventReg(std::make_shared<State>(State{event, cb, 0}), api) { }
+
+    ~ESPPooledEventReg() override
+    {
+        unregister();
+
+        Event &event = state->event;
+        std::lock_guard<std::mutex> lock(event.pool_mutex);
+        event.handler_bits &= ~state->bit;
+        for (Slot &slot : event.slots) {
+            if (slot.state == Event::SlotState::POSTED && (slot.pending & state->bit) != 0) {
+                event.release(slot, state->bit);
+            }
+        }
+    }
+
+private:
+    ESPPooledEventReg(std::shared_ptr<State> state, std::shared_ptr<ESPEventAPI> api)
+        : ESPEventReg(state->cb ? [state](const ESPEvent &event, void *event_data) {
+                    state->dispatch(event, event_data);
+                } : std::function<void(const ESPEvent &, void*)>(),
+                state->event.get_event(),
+                api),
+        state(state)
+    {
+        std::lock_guard<std::mutex> lock(state->event.pool_mutex);
+        const uint32_t free_bits = ~state->event.handler_bits;
+        if (free_bits == 0) {
+            throw EventException(ESP_ERR_NO_MEM);
+        }
+        state->bit = free_bits & -free_bits;
+        state->event.handler_bits |= state->bit;
+    }
+
+    std::shared_ptr<State> state;
+};
+
+template<typename T>
+class ESPCoalescedEventReg;
+
+/**
+ * Event whose data of type T is coalesced: only its latest value is dispatched, for "latest value" style events.
+ *
+ * When it is posted with ESPEventLoop::post_event() while a previous post is still pending in the event loop queue,
+ * the value is replaced and nothing is queued. So a slow handler doesn't fill the queue with stale values, and the
+ * posters don't wait for room in the queue. The value is kept in the event, and the event loop only carries a
+ * notification without data. Each handler registered with ESPEventLoop::register_event() receives the latest value
+ * when it is called, so a value posted during the dispatch of a notification may be received twice.
+ *
+ * @note The event keeps the value and the state of its handlers, so it must outlive them, and it must be used with a
+ *       single event loop.
+ * @note If no handler is registered when the event is posted, the value is kept but nothing is posted.
+ */
+template<typename T>
+class ESPCoalescedEvent {
+    static_assert(std::is_trivially_copyable_v<T>, "ESPCoalescedEvent data must be trivially copyable");
+
+public:
+    using DataType = T;
+    using Handler = std::function<void(const ESPEvent &, const T &)>;
+
+    ESPCoalescedEvent(esp_event_base_t event_base, const ESPEventID &event_id)
+        : event(event_base, event_id), value_mutex(), value(), pending(false), handlers(0), coalesced(0) { }
+
+    ESPCoalescedEvent(const ESPCoalescedEvent&) = delete;
+    ESPCoalescedEvent &operator=(const ESPCoalescedEvent&) = delete;
+
+    const ESPEvent &get_event() const
+    {
+        return event;
+    }
+
+    /**
+     * Return the number of posts which replaced the value of a pending event instead of being queued.
+     */
+    uint32_t get_coalesced_count() const
+    {
+        std::lock_guard<std::mutex> lock(value_mutex);
+        return coalesced;
+    }
+
+private:
+    friend class ESPEventLoop;
+    friend class ESPCoalescedEventReg<T>;
+
+    /**
+     * Replace the value, return true if a notification must be posted.
+     */
+    bool store(const T &new_value)
+    {
+        std::lock_guard<std::mutex> lock(value_mutex);
+        value = new_value;
+        if (pending) {
+            coalesced++;
+            return false;
+        }
+        pending = handlers != 0;
+        return pending;
+    }
+
+    /**
+     * The notification could not be posted, the value is kept for the next post.
+     */
+    void cancel_post()
+    {
+        std::lock_guard<std::mutex> lock(value_mutex);
+        pending = false;
+    }
+
+    /**
+     * Return the latest value, empty if the event was never posted with ESPEventLoop::post_event(). The following
+     * posts are queued again.
+     */
+    std::optional<T> take()
+    {
+        std::lock_guard<std::mutex> lock(value_mutex);
+        pending = false;
+        return value;
+    }
+
+    const ESPEvent event;
+
+    /**
+     * Protects the following members.
+     */
+    mutable std::mutex value_mutex;
+    std::optional<T> value;
+
+    /**
+     * True from a post until the dispatch of its notification.
+     */
+    bool pending;
+
+    size_t handlers;
+    uint32_t coalesced;
+};
+
+/**
+ * Registration of a handler of an ESPCoalescedEvent, obtained with ESPEventLoop::register_event().
+ */
+template<typename T>
+class ESPCoalescedEventReg : public ESPEventReg {
+    using Event = ESPCoalescedEvent<T>;
+
+public:
+    /**
+     * @throws EventException with error ESP_ERR_INVALID_ARG if cb or api are null
+     * @throws ESPEventRegisterException if the registration fails.
+     */
+    ESPCoalescedEventReg(typename Event::Handler cb, Event &event, std::shared_ptr<ESPEventAPI> api)
+        : ESPEventReg(cb ? [cb, coalesced = &event](const ESPEvent &event_id, void *event_data) {
+                    std::optional<T> value = coalesced->take();
+                    if (value) {
+                        cb(event_id, *value);
+                    }
+                } : std::function<void(const ESPEvent &, void*)>(),
+                event.get_event(),
+                api),
+        event(event)
+    {
+        std::lock_guard<std::mutex> lock(event.value_mutex);
+        event.handlers++;
+    }
+
+    ~ESPCoalescedEventReg() override
+    {
+        unregister();
+
+        std::lock_guard<std::mutex> lock(event.value_mutex);
+        event.handlers--;
+        if (event.handlers == 0) {
+            // A pending notification would reach no handler and the following posts would never be queued
+            event.pending = false;
+        }
+    }
+
+private:
+    Event &event;
+};
+
 class ESPEventLoop {
 public:
     /**
@@ -259,8 +765,13 @@ public:
      *            here.
      *
      * @note may throw EventException
+     * @note On the linux target, the default api is ESPEventAPIHost.
      */
+#if CONFIG_IDF_TARGET_LINUX
+    ESPEventLoop(std::shared_ptr<ESPEventAPI> api = std::make_shared<ESPEventAPIHost>());
+#else
     ESPEventLoop(std::shared_ptr<ESPEventAPI> api = std::make_shared<ESPEventAPIDefault>());
+#endif
 
     /**
      * Deletes the event loop implementation (depends on \c api).
@@ -279,6 +790,33 @@ public:
     std::unique_ptr<ESPEventReg> register_event(const ESPEvent &event,
             std::function<void(const ESPEvent &, void*)> cb);
 
+    /**
+     * Registers a handler receiving the data of a typed event as a \c const T&.
+     *
+     * @note may throw EventException, ESPEventRegisterException
+     */
+    template<typename T>
+    std::unique_ptr<ESPEventReg> register_event(const ESPTypedEvent<T> &event,
+            typename ESPTypedEvent<T>::Handler cb);
+
+    /**
+     * Registers a handler receiving the data of a pooled event as a \c const T&, without copy.
+     *
+     * @note may throw EventException, ESPEventRegisterException
+     */
+    template<typename T, std::size_t PoolSize>
+    std::unique_ptr<ESPEventReg> register_event(ESPPooledEvent<T, PoolSize> &event,
+            typename ESPPooledEvent<T, PoolSize>::Handler cb);
+
+    /**
+     * Registers a handler receiving the latest value of a coalesced event as a \c const T&.
+     *
+     * @note may throw EventException, ESPEventRegisterException
+     */
+    template<typename T>
+    std::unique_ptr<ESPEventReg> register_event(ESPCoalescedEvent<T> &event,
+            typename ESPCoalescedEvent<T>::Handler cb);
+
     /**
      * Sets a timeout for event. If the specified event isn't received within timeout,
      * timer_cb is called.
@@ -305,6 +843,56 @@ public:
             T &event_data,
             const std::chrono::milliseconds &wait_time = PLATFORM_MAX_DELAY_MS);
 
+    /**
+     * Posts a typed event and its data.
+     *
+     * @param event the event to post
+     * @param event_data The event data, copied into the event loop queue.
+     * @param wait_time the maximum wait time the function tries to post the event
+     */
+    template<typename T>
+    void post_event(const ESPTypedEvent<T> &event,
+            const typename ESPTypedEvent<T>::DataType &event_data,
+            const std::chrono::milliseconds &wait_time = PLATFORM_MAX_DELAY_MS);
+
+    /**
+     * Posts a pooled event and its data, only a pointer to the data is copied into the event loop queue.
+     *
+     * @param event the event to post
+     * @param event_data The event data obtained from \c event.acquire(), it is given to the event loop even if
+     *        posting fails.
+     * @param wait_time the maximum wait time the function tries to post the event
+     */
+    template<typename T, std::size_t PoolSize>
+    void post_event(ESPPooledEvent<T, PoolSize> &event,
+            typename ESPPooledEvent<T, PoolSize>::Data &&event_data,
+            const std::chrono::milliseconds &wait_time = PLATFORM_MAX_DELAY_MS);
+
+    /**
+     * Posts a coalesced event: its value is replaced, and it is only queued if it is not pending already.
+     *
+     * @param event the event to post
+     * @param event_data The new value of the event, copied into the event.
+     * @param wait_time the maximum wait time the function tries to post the event, when it is not pending.
+     */
+    template<typename T>
+    void post_event(ESPCoalescedEvent<T> &event,
+            const typename ESPCoalescedEvent<T>::DataType &event_data,
+            const std::chrono::milliseconds &wait_time = PLATFORM_MAX_DELAY_MS);
+
+    /**
+     * Posts several events and their data in order, with a single wait for room in the queue when the API supports
+     * it (ESPEventAPIHost). With the esp_event loops, the events are posted one by one, each waiting up to wait_time,
+     * and the events before a failing one are posted.
+     *
+     * @param events the events to post with their data, the data is copied into the event loop queue.
+     * @param wait_time the maximum wait time the function tries to post the events
+     *
+     * @note may throw ESPException
+     */
+    void post_batch(std::span<const ESPEventBatchItem> events,
+            const std::chrono::milliseconds &wait_time = PLATFORM_MAX_DELAY_MS);
+
     /**
      * Posts an event.
      *
@@ -340,6 +928,93 @@ void ESPEventLoop::post_event_data(const ESPEvent &event,
     }
 }
 
+template<typename T>
+std::unique_ptr<ESPEventReg> ESPEventLoop::register_event(const ESPTypedEvent<T> &event,
+        typename ESPTypedEvent<T>::Handler cb)
+{
+    if (!cb) throw EventException(ESP_ERR_INVALID_ARG);
+
+    return register_event(static_cast<const ESPEvent&>(event),
+            std::function<void(const ESPEvent &, void*)>([cb](const ESPEvent &event, void *event_data) {
+                cb(event, *static_cast<const T*>(event_data));
+            }));
+}
+
+template<typename T, std::size_t PoolSize>
+std::unique_ptr<ESPEventReg> ESPEventLoop::register_event(ESPPooledEvent<T, PoolSize> &event,
+        typename ESPPooledEvent<T, PoolSize>::Handler cb)
+{
+    return std::unique_ptr<ESPEventReg>(new ESPPooledEventReg<T, PoolSize>(cb, event, api));
+}
+
+template<typename T>
+void ESPEventLoop::post_event(const ESPTypedEvent<T> &event,
+        const typename ESPTypedEvent<T>::DataType &event_data,
+        const std::chrono::milliseconds &wait_time)
+{
+    esp_err_t result = api->post(event.base,
+            event.id.get_id(),
+            const_cast<T*>(&event_data),
+            sizeof(event_data),
+            convert_ms_to_ticks(wait_time));
+
+    if (result != ESP_OK) {
+        throw ESPException(result);
+    }
+}
+
+template<typename T, std::size_t PoolSize>
+void ESPEventLoop::post_event(ESPPooledEvent<T, PoolSize> &event,
+        typename ESPPooledEvent<T, PoolSize>::Data &&event_data,
+        const std::chrono::milliseconds &wait_time)
+{
+    auto *slot = event.prepare_post(event_data);
+    if (slot == nullptr) {
+        return;
+    }
+
+    const ESPEvent &posted = event.get_event();
+    esp_err_t result = api->post(posted.base,
+            posted.id.get_id(),
+            &slot,
+            sizeof(slot),
+            convert_ms_to_ticks(wait_time));
+    event.finish_post(*slot, result == ESP_OK);
+
+    if (result != ESP_OK) {
+        throw ESPException(result);
+    }
+}
+
+template<typename T>
+std::unique_ptr<ESPEventReg> ESPEventLoop::register_event(ESPCoalescedEvent<T> &event,
+        typename ESPCoalescedEvent<T>::Handler cb)
+{
+    return std::unique_ptr<ESPEventReg>(new ESPCoalescedEventReg<T>(cb, event, api));
+}
+
+template<typename T>
+void ESPEventLoop::post_event(ESPCoalescedEvent<T> &event,
+        const typename ESPCoalescedEvent<T>::DataType &event_data,
+        const std::chrono::milliseconds &wait_time)
+{
+    if (!event.store(event_data)) {
+        return;
+    }
+
+    const ESPEvent &posted = event.get_event();
+    esp_err_t result = api->post(posted.base,
+            posted.id.get_id(),
+            nullptr,
+            0,
+            convert_ms_to_ticks(wait_time));
+
+    if (result != ESP_OK) {
+        event.cancel_post();
+        throw ESPException(result);
+    }
+}
+
 } // namespace event
 
 } // namespace idf
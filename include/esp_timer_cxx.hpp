@@ -9,8 +9,16 @@
 #ifdef __cpp_exceptions
 
 #include <chrono>
+#include <cstddef>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include "sdkconfig.h"
+#include "esp_attr.h"
 #include "esp_exception.hpp"
 #include "esp_timer.h"
 
@@ -37,6 +45,46 @@ static inline std::chrono::microseconds get_next_alarm()
     return std::chrono::microseconds(esp_timer_get_next_alarm());
 }
 
+/**
+ * @brief Clock of the esp_timer component, meeting the TrivialClock requirements of the standard library.
+ *
+ * The epoch is the time when \c esp_timer_init() was called, so the time since the epoch of \c clock::now() is the
+ * value returned by \c get_time().
+ */
+struct clock {
+    using rep = int64_t;
+    using period = std::micro;
+    using duration = std::chrono::microseconds;
+    using time_point = std::chrono::time_point<clock>;
+
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept
+    {
+        return time_point(duration(esp_timer_get_time()));
+    }
+};
+
+/**
+ * @brief Name of a timer which is used without being copied.
+ *
+ * It can only be constructed explicitly from a string literal (or another array with static storage), so that the
+ * name outlives the timer. A name given as a \c std::string, a \c char array or a \c const \c char* binds to the
+ * constructors taking a \c std::string, which copy it.
+ */
+class StaticName {
+public:
+    template<std::size_t N>
+    explicit consteval StaticName(const char (&name)[N]) : name(name) { }
+
+    constexpr const char *get() const
+    {
+        return name;
+    }
+
+private:
+    const char *name;
+};
 
 /**
  * @brief
@@ -45,10 +93,144 @@ static inline std::chrono::microseconds get_next_alarm()
 class ESPTimer {
 public:
     /**
-     * @param timeout_cb The timeout callback.
+     * @brief Maximum size of a callback stored inside the timer.
+     */
+    static constexpr std::size_t INLINE_CALLBACK_SIZE = 4 * sizeof(void *);
+
+    /**
+     * @brief Statistics of the timer callback calls, see enable_stats().
+     */
+    struct Stats {
+        /**
+         * Number of calls of the callback.
+         */
+        uint32_t calls;
+
+        /**
+         * Number of periods whose callback started after the next period was due, plus the number of periods
+         * skipped because of \c skip_unhandled_events.
+         */
+        uint32_t missed_periods;
+
+        /**
+         * Maximum and mean delay between the expected and the actual start of the callback of a periodic timer.
+         */
+        std::chrono::microseconds max_lateness;
+        std::chrono::microseconds mean_lateness;
+
+        /**
+         * Maximum and mean execution time of the callback.
+         */
+        std::chrono::microseconds max_execution_time;
+        std::chrono::microseconds mean_execution_time;
+    };
+
+    /**
+     * @brief True if a callback of this type can be stored inside the timer, without heap allocation.
+     */
+    template<typename Callback>
+    static constexpr bool is_inline_callback = std::is_invocable_r_v<void, std::decay_t<Callback> &>
+            && !std::is_same_v<std::decay_t<Callback>, std::function<void()>>
+            && sizeof(std::decay_t<Callback>) <= INLINE_CALLBACK_SIZE
+            && alignof(std::decay_t<Callback>) <= alignof(std::max_align_t)
+            && std::is_nothrow_destructible_v<std::decay_t<Callback>>;
+
+    /**
+     * @param timeout_cb The timeout callback, called from the esp_timer task.
+     * @param timer_name The name of the timer (optional). This is for debugging using \c esp_timer_dump().
+     * @param skip_unhandled_events For a periodic timer, if the timeout was missed several times (e.g. during light
+     *        sleep), call the callback only once instead of once per missed period.
+     */
+    ESPTimer(std::function<void()> timeout_cb,
+            const std::string &timer_name = "ESPTimer",
+            bool skip_unhandled_events = false);
+
+    /**
+     * @brief Same as the other constructor, without copying the name.
+     *
+     * @param timer_name The name of the timer, e.g. \c StaticName("my_timer").
+     */
+    ESPTimer(std::function<void()> timeout_cb, StaticName timer_name, bool skip_unhandled_events = false);
+
+    /**
+     * @brief Create a timer without any heap allocation.
+     *
+     * The callback, a function pointer or a function object (e.g. a lambda) of at most \c INLINE_CALLBACK_SIZE
+     * bytes, is stored inside the timer instead of in a \c std::function, and the name is not copied. Short-lived
+     * timers can then be created and deleted at a high rate.
+     *
+     * @note A name given as a string (e.g. \c ESPTimer(lambda, "name")) selects the \c std::function constructor,
+     *       which copies it. Use \c StaticName("name") to stay allocation free.
+     *
+     * @param timeout_cb The timeout callback, called from the esp_timer task.
+     * @param timer_name The name of the timer, e.g. \c StaticName("my_timer").
+     * @param skip_unhandled_events For a periodic timer, if the timeout was missed several times (e.g. during light
+     *        sleep), call the callback only once instead of once per missed period.
+     *
+     * @throws ESPException with error ESP_ERR_INVALID_ARG if timeout_cb is a null function pointer.
+     */
+    template<typename Callback>
+        requires (is_inline_callback<Callback>)
+    ESPTimer(Callback &&timeout_cb,
+            StaticName timer_name = StaticName("ESPTimer"),
+            bool skip_unhandled_events = false)
+        : timeout_cb(), name_storage(), name(timer_name.get())
+    {
+        using Stored = std::decay_t<Callback>;
+        if constexpr (std::is_pointer_v<Stored>) {
+            if (timeout_cb == nullptr) {
+                throw ESPException(ESP_ERR_INVALID_ARG);
+            }
+        }
+
+        new (inline_callback) Stored(std::forward<Callback>(timeout_cb));
+        inline_invoke = [](void *storage) { (*static_cast<Stored *>(storage))(); };
+        inline_destroy = [](void *storage) { static_cast<Stored *>(storage)->~Stored(); };
+        try {
+            create(esp_timer_cb, ESP_TIMER_TASK, skip_unhandled_events);
+        } catch (...) {
+            inline_destroy(inline_callback);
+            throw;
+        }
+    }
+
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    /**
+     * @brief Callback called directly from the esp_timer interrupt.
+     *
+     * It must be placed in IRAM (IRAM_ATTR) and only call ISR safe functions.
+     *
+     * @param arg The argument given to the constructor.
+     * @return true if the callback unblocked a higher priority task, a context switch is then requested at the end
+     *         of the interrupt.
+     */
+    using ISRCallback = bool (*)(void *arg);
+
+    /**
+     * @brief Create a timer whose callback is called from the esp_timer interrupt instead of the esp_timer task.
+     *
+     * The latency and jitter then don't depend on the other callbacks run in the esp_timer task.
+     *
+     * @param isr_cb The timeout callback.
+     * @param arg The argument given to the callback.
      * @param timer_name The name of the timer (optional). This is for debugging using \c esp_timer_dump().
+     * @param skip_unhandled_events For a periodic timer, if the timeout was missed several times, call the callback
+     *        only once instead of once per missed period.
+     *
+     * @throws ESPException with error ESP_ERR_INVALID_ARG if isr_cb is null.
      */
-    ESPTimer(std::function<void()> timeout_cb, const std::string &timer_name = "ESPTimer");
+    ESPTimer(ISRCallback isr_cb,
+            void *arg,
+            const std::string &timer_name = "ESPTimer",
+            bool skip_unhandled_events = false);
+
+    /**
+     * @brief Same as the other constructor, without copying the name.
+     *
+     * @param timer_name The name of the timer, e.g. \c StaticName("my_timer").
+     */
+    ESPTimer(ISRCallback isr_cb, void *arg, StaticName timer_name, bool skip_unhandled_events = false);
+#endif
 
     /**
      * Stop the timer if necessary and delete it.
@@ -76,9 +258,70 @@ public:
      */
     inline void start(std::chrono::microseconds timeout)
     {
+        if (stats_state) {
+            stats_on_start(0, 0);
+        }
         CHECK_THROW(esp_timer_start_once(timer_handle, timeout.count()));
     }
 
+    /**
+     * @brief Start one-shot timer at an absolute time
+     *
+     * Chaining start_at() calls from the callback with a deadline incremented by a constant period gives a schedule
+     * which doesn't drift, whatever the callback latency. If the time is already passed, the timer triggers as soon
+     * as possible.
+     *
+     * Timer should not be running (started) when this function is called.
+     *
+     * @param time the time when the timer triggers, with the same timebase as \c get_time().
+     *
+     * @throws ESPException with error ESP_ERR_INVALID_STATE if the timer is already running.
+     */
+    inline void start_at(clock::time_point time)
+    {
+        start_at(time.time_since_epoch());
+    }
+
+    /**
+     * @brief Start one-shot timer at an absolute time
+     *
+     * Same as \c start_at(clock::time_point), with the time given since the epoch of \c clock.
+     */
+    inline void start_at(std::chrono::microseconds time)
+    {
+        if (stats_state) {
+            stats_on_start(0, 0);
+        }
+        const int64_t timeout = time.count() - esp_timer_get_time();
+        CHECK_THROW(esp_timer_start_once(timer_handle, timeout > 0 ? timeout : 0));
+    }
+
+    /**
+     * @brief Restart the timer with a new timeout
+     *
+     * If the timer is running, it is restarted with a single call to the underlying timer framework, which keeps its
+     * type: a one-shot timer triggers after the timeout and a periodic timer gets the timeout as new period. If the
+     * timer is not running, it is started as a one-shot timer. Unlike \c stop() followed by \c start(), this never
+     * throws because of the state of the timer, so it fits watchdog-like timers kicked at a high rate.
+     *
+     * @param timeout timer timeout or period, in microseconds relative to the current moment.
+     *
+     * @throws ESPException if the underlying timer framework fails.
+     */
+    inline void restart(std::chrono::microseconds timeout)
+    {
+        esp_err_t error = esp_timer_restart(timer_handle, timeout.count());
+        if (error == ESP_ERR_INVALID_STATE) {
+            if (stats_state) {
+                stats_on_start(0, 0);
+            }
+            error = esp_timer_start_once(timer_handle, timeout.count());
+        } else if (error == ESP_OK && stats_state) {
+            stats_on_restart(timeout.count());
+        }
+        CHECK_THROW(error);
+    }
+
     /**
      * @brief Start periodic timer
      *
@@ -93,6 +336,9 @@ public:
      */
     inline void start_periodic(std::chrono::microseconds period)
     {
+        if (stats_state) {
+            stats_on_start(esp_timer_get_time() + period.count(), period.count());
+        }
         CHECK_THROW(esp_timer_start_periodic(timer_handle, period.count()));
     }
 
@@ -108,6 +354,18 @@ public:
         CHECK_THROW(esp_timer_stop(timer_handle));
     }
 
+    /**
+     * @brief Stop the timer if it is running, without throwing.
+     *
+     * @return
+     *      - true if the timer was running and is stopped
+     *      - false if the timer was not running.
+     */
+    inline bool try_stop() noexcept
+    {
+        return esp_timer_stop(timer_handle) == ESP_OK;
+    }
+
     /**
      * @brief Returns status of a timer, active or not
      *
@@ -122,26 +380,130 @@ public:
         return esp_timer_is_active(timer_handle);
     }
 
+    /**
+     * @brief Start collecting statistics of the callback calls.
+     *
+     * Each call of the callback then reads the time before and after the callback. For a periodic timer, the actual
+     * start of the callback is compared with its expected time, which is the start time of the timer plus a multiple
+     * of the period, so the lateness doesn't include the latency of the previous calls.
+     *
+     * @note The statistics are not collected for the ISR dispatch method.
+     *
+     * @throws ESPException with error ESP_ERR_INVALID_STATE if the timer is running.
+     */
+    void enable_stats();
+
+    /**
+     * @brief Return the statistics collected since enable_stats() or reset_stats().
+     *
+     * @throws ESPException with error ESP_ERR_INVALID_STATE if the statistics are not enabled.
+     */
+    Stats get_stats() const;
+
+    /**
+     * @brief Reset the statistics, the expected time of the next call of a periodic timer is kept.
+     *
+     * @throws ESPException with error ESP_ERR_INVALID_STATE if the statistics are not enabled.
+     */
+    void reset_stats();
+
 private:
+    /**
+     * Accumulated statistics, protected by their mutex since they are written from the esp_timer task.
+     */
+    struct StatsState {
+        std::mutex mutex;
+        int64_t period_us = 0;
+        int64_t expected_us = 0;
+        uint32_t calls = 0;
+        uint32_t periodic_calls = 0;
+        uint32_t missed_periods = 0;
+        int64_t max_lateness_us = 0;
+        int64_t total_lateness_us = 0;
+        int64_t max_execution_us = 0;
+        int64_t total_execution_us = 0;
+    };
+
+    /**
+     * Update the schedule of the statistics when the timer is started, a period of 0 means a one-shot timer.
+     */
+    void stats_on_start(int64_t expected_us, int64_t period_us) noexcept;
+
+    /**
+     * Update the schedule of the statistics when the running timer is restarted with a new timeout.
+     */
+    void stats_on_restart(int64_t timeout_us) noexcept;
+
+    /**
+     * Call the callback and update the statistics.
+     */
+    void call_with_stats();
+
+    /**
+     * Create the underlying timer.
+     */
+    void create(esp_timer_cb_t callback, esp_timer_dispatch_t dispatch_method, bool skip_unhandled_events);
+
     /**
      * Internal callback to hook into esp_timer component.
      */
     static void esp_timer_cb(void *arg);
 
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    /**
+     * Internal callback to hook into esp_timer component with the ISR dispatch method.
+     */
+    static void IRAM_ATTR esp_timer_isr_cb(void *arg);
+#endif
+
     /**
      * Timer instance of the underlying esp_event component.
      */
     esp_timer_handle_t timer_handle;
 
     /**
-     * Callback which will be called once the timer triggers.
+     * Callback which will be called once the timer triggers, if inline_invoke is null.
      */
     std::function<void()> timeout_cb;
 
+    /**
+     * Storage of a callback stored inside the timer, and functions to call and destroy it.
+     */
+    alignas(std::max_align_t) unsigned char inline_callback[INLINE_CALLBACK_SIZE];
+    void (*inline_invoke)(void *storage) = nullptr;
+    void (*inline_destroy)(void *storage) = nullptr;
+
+    /**
+     * Whether missed periods are skipped, to predict the schedule of a periodic timer.
+     */
+    bool skip_unhandled_events = false;
+
+    /**
+     * Statistics, null unless enable_stats() is called.
+     */
+    std::unique_ptr<StatsState> stats_state;
+
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    /**
+     * Callback which will be called from the interrupt once the timer triggers, if not null.
+     */
+    ISRCallback isr_cb = nullptr;
+
+    /**
+     * Argument of isr_cb.
+     */
+    void *isr_arg = nullptr;
+#endif
+
+    /**
+     * Copy of the name of the timer if it was given as a \c std::string, empty for a StaticName.
+     */
+    const std::string name_storage;
+
     /**
      * Name of the timer, will be passed to the underlying timer framework and is used for debugging.
      */
-    const std::string name;
+    const char *const name;
 };
 
 } // esp_timer
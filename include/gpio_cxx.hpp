@@ -8,11 +8,19 @@
 
 #if __cpp_exceptions
 
+#include "sdkconfig.h"
 #include "esp_exception.hpp"
 #include "system_cxx.hpp"
+#include "gpio_reg_cxx.hpp"
 #include "hal/gpio_types.h"
+#include "esp_attr.h"
 
+#include <array>
+#include <atomic>
 #include <functional>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 
 
 namespace idf {
@@ -27,6 +35,43 @@ struct GPIOException : public ESPException {
     GPIOException(esp_err_t error);
 };
 
+namespace detail {
+#if CONFIG_IDF_TARGET_LINUX
+inline constexpr std::array<uint32_t, 1> INVALID_GPIOS = {24};
+#elif CONFIG_IDF_TARGET_ESP32
+inline constexpr std::array<uint32_t, 1> INVALID_GPIOS = {24};
+#elif CONFIG_IDF_TARGET_ESP32S2
+inline constexpr std::array<uint32_t, 4> INVALID_GPIOS = {22, 23, 24, 25};
+#elif CONFIG_IDF_TARGET_ESP32S3
+inline constexpr std::array<uint32_t, 4> INVALID_GPIOS = {22, 23, 24, 25};
+#elif CONFIG_IDF_TARGET_ESP32C3
+inline constexpr std::array<uint32_t, 0> INVALID_GPIOS = {};
+#elif CONFIG_IDF_TARGET_ESP32C2
+inline constexpr std::array<uint32_t, 0> INVALID_GPIOS = {};
+#else
+#error "No GPIOs defined for the current target"
+#endif
+} // detail
+
+/**
+ * Check at compile time or at run time if the numeric pin number is valid on the current hardware.
+ */
+constexpr bool is_valid_gpio_pin_num(uint32_t pin_num) noexcept
+{
+    if (pin_num >= GPIO_NUM_MAX) {
+        return false;
+    }
+
+    for (auto num: detail::INVALID_GPIOS)
+    {
+        if (pin_num == num) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /**
  * Check if the numeric pin number is valid on the current hardware.
  */
@@ -37,6 +82,14 @@ esp_err_t check_gpio_pin_num(uint32_t pin_num) noexcept;
  */
 esp_err_t check_gpio_drive_strength(uint32_t strength) noexcept;
 
+/**
+ * @brief Configure all the GPIOs of a pin bit mask as outputs, without pull resistors nor interrupt, with a single
+ *        driver call.
+ *
+ * @throws GPIOException if the underlying driver function fails.
+ */
+void configure_gpio_outputs(uint64_t pin_bit_mask);
+
 /**
  * This is a "Strong Value Type" class for GPIO. The GPIO pin number is checked during construction according to
  * the hardware capabilities. This means that any GPIONumBase object is guaranteed to contain a valid GPIO number.
@@ -58,8 +111,31 @@ public:
         }
     }
 
+    /**
+     * @brief Create a pin number representation from a constant, checked at compile time.
+     *
+     * An invalid pin number is a compilation error. The result is a constant expression, without run time check
+     * nor exception, e.g. \c constexpr GPIONum LED_GPIO = GPIONum::make<18>();
+     *
+     * @tparam Pin The GPIO pin number.
+     */
+    template<uint32_t Pin>
+    static constexpr GPIONumBase make() noexcept
+    {
+        static_assert(is_valid_gpio_pin_num(Pin), "Invalid GPIO number on the current hardware");
+        return GPIONumBase(Pin, Checked());
+    }
+
     using StrongValueComparable<uint32_t>::operator==;
     using StrongValueComparable<uint32_t>::operator!=;
+
+private:
+    /**
+     * Tag of the constructor used once the pin number is known to be valid.
+     */
+    struct Checked { };
+
+    constexpr GPIONumBase(uint32_t pin, Checked) noexcept : StrongValueComparable<uint32_t>(pin) { }
 };
 
 /**
@@ -105,6 +181,12 @@ public:
      */
     static GPIOPullMode PULLDOWN();
 
+    /**
+     * Create a representation of a configuration with both the pullup and the pulldown enabled.
+     * For more information, check the driver and HAL files.
+     */
+    static GPIOPullMode PULLUP_PULLDOWN();
+
     using StrongValueComparable<uint32_t>::operator==;
     using StrongValueComparable<uint32_t>::operator!=;
 };
@@ -192,6 +274,20 @@ public:
     using StrongValueComparable<uint32_t>::operator!=;
 };
 
+class GPIOConfigBatch;
+
+/**
+ * @brief Proof that a GPIO was already configured by a GPIOConfigBatch.
+ *
+ * Only GPIOConfigBatch can create it, so the constructors taking it can't be used with a GPIO which is not configured.
+ */
+class GPIOConfigured {
+private:
+    constexpr GPIOConfigured() = default;
+
+    friend class GPIOConfigBatch;
+};
+
 /**
  * @brief Implementations commonly used functionality for all GPIO configurations.
  *
@@ -201,6 +297,15 @@ public:
  * and possibly make some of the functionality publicly available.
  */
 class GPIOBase {
+public:
+    /**
+     * @brief Return the number of the configured GPIO pin.
+     */
+    GPIONum get_num() const noexcept
+    {
+        return gpio_num;
+    }
+
 protected:
     /**
      * @brief Construct a GPIO.
@@ -215,6 +320,11 @@ protected:
      */
     GPIOBase(GPIONum num);
 
+    /**
+     * @brief Construct a GPIO already configured by a GPIOConfigBatch, without any driver call.
+     */
+    GPIOBase(GPIONum num, GPIOConfigured) noexcept;
+
     /**
      * @brief Enable gpio pad hold function.
      *
@@ -273,6 +383,13 @@ public:
      */
     GPIO_Output(GPIONum num);
 
+    /**
+     * @brief Construct an output already configured by a GPIOConfigBatch, without any driver call.
+     *
+     * @see GPIOConfigBatch::output()
+     */
+    GPIO_Output(GPIONum num, GPIOConfigured) noexcept;
+
     /**
      * @brief Set GPIO to high level.
      *
@@ -287,8 +404,116 @@ public:
      */
     void set_low() const;
 
+    /**
+     * @brief Set GPIO to high level with a single register write.
+     *
+     * Unlike \c set_high(), this function doesn't go through the GPIO driver: the pin was validated and
+     * configured during construction, so nothing can fail here. It is inline and can be used from an ISR.
+     */
+    void set() const noexcept
+    {
+        gpio_reg::set_bits(pin_mask.bank, pin_mask.mask);
+    }
+
+    /**
+     * @brief Set GPIO to low level with a single register write.
+     *
+     * See \c set() for the differences with \c set_low().
+     */
+    void clear() const noexcept
+    {
+        gpio_reg::clear_bits(pin_mask.bank, pin_mask.mask);
+    }
+
+    /**
+     * @brief Set GPIO to high level if \c level is true, to low level otherwise, with a single register write.
+     */
+    void write(bool level) const noexcept
+    {
+        if (level) {
+            set();
+        } else {
+            clear();
+        }
+    }
+
+    /**
+     * @brief Invert the level of the GPIO.
+     *
+     * @note The current level is read from the output register, the read and the write are not atomic if another
+     *       task or ISR also writes this pin.
+     */
+    void toggle() const noexcept
+    {
+        write((gpio_reg::read_output(pin_mask.bank) & pin_mask.mask) == 0u);
+    }
+
     using GPIOBase::set_drive_strength;
     using GPIOBase::get_drive_strength;
+
+private:
+    /**
+     * Location of the pin in the output registers, computed once for the fast functions.
+     */
+    gpio_reg::PinMask pin_mask;
+};
+
+/**
+ * @brief Shared GPIO ISR service, installed while at least one GPIOInput has an ISR handler.
+ *
+ * The service is reference counted: acquire() installs it for the first user and release() uninstalls it after the
+ * last one. Users can be created and destroyed from several tasks. If the service was already installed by other
+ * code, it is used as is and never uninstalled.
+ */
+class GPIOISRService {
+public:
+    /**
+     * @brief Set the interrupt allocation flags used the next time the service is installed.
+     *
+     * Used to change the interrupt priority level (ESP_INTR_FLAG_LEVEL1 to ESP_INTR_FLAG_LEVEL3), to keep the interrupt
+     * enabled while the flash cache is disabled (ESP_INTR_FLAG_IRAM) or to share it (ESP_INTR_FLAG_SHARED). The default
+     * is 0, a shared low priority level.
+     *
+     * @note With ESP_INTR_FLAG_IRAM, all the handlers must be in IRAM. Handlers registered with GPIOInput::on_edge()
+     *       are called from IRAM trampolines, the CallBack given to the GPIOInput constructor is not.
+     *
+     * @param intr_alloc_flags ESP_INTR_FLAG_* flags, as given to gpio_install_isr_service().
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_STATE if the service is already installed with different flags
+     */
+    static void set_flags(int intr_alloc_flags);
+
+    /**
+     * @brief Return the interrupt allocation flags used to install the service.
+     */
+    static int get_flags() noexcept;
+
+    /**
+     * @brief Add a user to the service, installing it if needed.
+     *
+     * @throws GPIOException if installing the service fails.
+     */
+    static void acquire();
+
+    /**
+     * @brief Remove a user from the service, uninstalling it after the last one.
+     */
+    static void release() noexcept;
+
+    /**
+     * @brief Return the current number of users.
+     */
+    static uint32_t get_user_count() noexcept;
+
+private:
+    GPIOISRService() = delete;
+
+    static std::atomic<uint32_t> _users;
+    static std::mutex _mutex;
+    static int _flags;
+    static bool _installed;
+    static bool _owned;
 };
 
 /**
@@ -310,11 +535,64 @@ public:
      */
     GPIOInput(GPIONum num, gpio_int_type_t intType = GPIO_INTR_DISABLE, const CallBack & callback = CallBack());
 
+    /**
+     * @brief Construct an input already configured by a GPIOConfigBatch, without any driver call.
+     *
+     * An ISR handler can then be registered with on_edge().
+     *
+     * @see GPIOConfigBatch::input()
+     */
+    GPIOInput(GPIONum num, GPIOConfigured) noexcept;
+
     /**
      * @brief If create with ISR handler remove it
      */
     ~GPIOInput();
 
+    /**
+     * @brief Register a function called directly from the GPIO ISR.
+     *
+     * Unlike the \c CallBack given to the constructor, the handler is a template parameter: the ISR calls it through
+     * a trampoline placed in IRAM, without \c std::function indirection nor heap allocation, and the compiler can
+     * inline it. The handler itself must also be placed in IRAM (IRAM_ATTR) to run while the flash cache is
+     * disabled.
+     *
+     * @tparam Handler A function or static member function taking a \c Ctx pointer.
+     * @param ctx The context given to the handler, it must outlive this GPIOInput.
+     * @param intType GPIO interrupt type, must not be GPIO_INTR_DISABLE.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_STATE if an ISR handler is already registered
+     *              - ESP_ERR_INVALID_ARG if intType is GPIO_INTR_DISABLE
+     *              - if the underlying driver function fails
+     */
+    template<auto Handler, typename Ctx>
+    void on_edge(Ctx *ctx, gpio_int_type_t intType = GPIO_INTR_ANYEDGE)
+    {
+        static_assert(std::is_invocable_v<decltype(Handler), Ctx *>, "Handler must be callable with a Ctx pointer");
+        add_isr_handler(intType, &isr_trampoline<Handler, Ctx>, ctx);
+    }
+
+    /**
+     * @brief Register a function object called directly from the GPIO ISR.
+     *
+     * Same as the other overload, the call operator of \c Functor is called without \c std::function indirection.
+     *
+     * @param functor The function object, it is not copied and must outlive this GPIOInput.
+     * @param intType GPIO interrupt type, must not be GPIO_INTR_DISABLE.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_STATE if an ISR handler is already registered
+     *              - ESP_ERR_INVALID_ARG if intType is GPIO_INTR_DISABLE
+     *              - if the underlying driver function fails
+     */
+    template<typename Functor>
+    void on_edge(Functor &functor, gpio_int_type_t intType = GPIO_INTR_ANYEDGE)
+    {
+        static_assert(std::is_invocable_v<Functor &>, "Functor must be callable without argument");
+        add_isr_handler(intType, &functor_trampoline<Functor>, &functor);
+    }
+
     /**
      * @brief Read the current level of the GPIO.
      *
@@ -346,8 +624,29 @@ public:
     void wakeup_disable() const;
 
 private:
+    using ISRHandler = void (*)(void *);
+
+    template<auto Handler, typename Ctx>
+    static void IRAM_ATTR isr_trampoline(void *arg)
+    {
+        Handler(static_cast<Ctx *>(arg));
+    }
+
+    template<typename Functor>
+    static void IRAM_ATTR functor_trampoline(void *arg)
+    {
+        (*static_cast<Functor *>(arg))();
+    }
+
+    static void callback_trampoline(void *arg);
+
+    /**
+     * @brief Set the interrupt type and add the handler to the GPIO ISR service, installing it if necessary.
+     */
+    void add_isr_handler(gpio_int_type_t intType, ISRHandler handler, void *arg);
+
     CallBack _callback;
-    static int _isrHandlerCount;
+    bool _isr_handler_added;
 };
 
 /**
@@ -367,6 +666,13 @@ public:
      */
     GPIO_OpenDrain(GPIONum num);
 
+    /**
+     * @brief Construct an open drain GPIO already configured by a GPIOConfigBatch, without any driver call.
+     *
+     * @see GPIOConfigBatch::open_drain()
+     */
+    GPIO_OpenDrain(GPIONum num, GPIOConfigured) noexcept;
+
     /**
      * @brief Set GPIO to floating level.
      *
@@ -385,6 +691,256 @@ public:
     using GPIOBase::get_drive_strength;
 };
 
+/**
+ * @brief Configure many GPIOs at startup with a few driver calls.
+ *
+ * The GPIOs are first added with their configuration, then apply() calls gpio_config() once per group of GPIOs with
+ * the same configuration. The configured GPIOs are finally handed back as GPIO_Output, GPIOInput or GPIO_OpenDrain
+ * objects which don't call the driver again during their construction.
+ *
+ * @code
+ * GPIOConfigBatch batch;
+ * batch.add_output(LED_GPIO).add_output(CS_GPIO).add_input(BUTTON_GPIO, GPIOPullMode::PULLUP());
+ * batch.apply();
+ * GPIO_Output led = batch.output(LED_GPIO);
+ * @endcode
+ */
+class GPIOConfigBatch {
+public:
+    GPIOConfigBatch();
+
+    /**
+     * @brief Add an output, without pull resistors nor interrupt.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_ARG if the GPIO is already in the batch
+     *              - ESP_ERR_INVALID_STATE if the batch is already applied
+     */
+    GPIOConfigBatch & add_output(GPIONum num);
+
+    /**
+     * @brief Add an input.
+     *
+     * @param num GPIO pin number.
+     * @param pull_mode The pull resistors of the input.
+     * @param intType GPIO interrupt type, the ISR handler is then registered with GPIOInput::on_edge().
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_ARG if the GPIO is already in the batch
+     *              - ESP_ERR_INVALID_STATE if the batch is already applied
+     */
+    GPIOConfigBatch & add_input(GPIONum num,
+            GPIOPullMode pull_mode = GPIOPullMode::FLOATING(),
+            gpio_int_type_t intType = GPIO_INTR_DISABLE);
+
+    /**
+     * @brief Add an open drain output, also usable as input, without pull resistors nor interrupt.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_ARG if the GPIO is already in the batch
+     *              - ESP_ERR_INVALID_STATE if the batch is already applied
+     */
+    GPIOConfigBatch & add_open_drain(GPIONum num);
+
+    /**
+     * @brief Configure all the added GPIOs, with one gpio_config() call per group of identical configurations.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_STATE if the batch is already applied
+     *              - if the underlying driver function fails
+     */
+    void apply();
+
+    /**
+     * @brief Return an added output, without any driver call.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_STATE if the batch is not applied
+     *              - ESP_ERR_INVALID_ARG if the GPIO was not added as an output
+     */
+    GPIO_Output output(GPIONum num) const;
+
+    /**
+     * @brief Return an added input, without any driver call.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_STATE if the batch is not applied
+     *              - ESP_ERR_INVALID_ARG if the GPIO was not added as an input
+     */
+    GPIOInput input(GPIONum num) const;
+
+    /**
+     * @brief Return an added open drain GPIO, without any driver call.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_STATE if the batch is not applied
+     *              - ESP_ERR_INVALID_ARG if the GPIO was not added as an open drain output
+     */
+    GPIO_OpenDrain open_drain(GPIONum num) const;
+
+private:
+    /**
+     * @brief The configuration shared by a group of GPIOs.
+     */
+    struct Group {
+        gpio_mode_t mode;
+        gpio_pull_mode_t pull_mode;
+        gpio_int_type_t intr_type;
+        uint64_t pin_bit_mask;
+    };
+
+    void add(GPIONum num, gpio_mode_t mode, gpio_pull_mode_t pull_mode, gpio_int_type_t intr_type);
+
+    void check_added(GPIONum num, gpio_mode_t mode) const;
+
+    std::vector<Group> _groups;
+    uint64_t _pin_bit_mask;
+    bool _applied;
+};
+
+/**
+ * @brief A group of GPIOs configured as outputs and written together as the bits of a value.
+ *
+ * All the masks are computed during construction. write() is then one store of the output register per 32 pins
+ * bank instead of one driver call per pin: all the pins of a bank change at the same time, and when the pins span
+ * two banks, the pins of the first bank change before those of the second one. Typical uses are LCD 8080 data buses
+ * or shift register latches, with all their pins in one bank.
+ *
+ * @tparam N The number of pins of the bus, at most 32.
+ */
+template<std::size_t N>
+class GPIOBus {
+    static_assert(N > 0u && N <= 32u, "A GPIOBus has between 1 and 32 pins");
+
+public:
+    /**
+     * @brief Construct and configure the GPIOs of the bus as outputs.
+     *
+     * @param pins The GPIOs of the bus, the first one is bit 0 of the written values.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_ARG if the same GPIO is used twice
+     *              - if the underlying driver function fails
+     */
+    explicit GPIOBus(const std::array<GPIONum, N> &pins) : pin_masks(), bank_masks(), shift(-1)
+    {
+        uint64_t pin_bit_mask = 0u;
+        for (std::size_t i = 0u; i < N; i++) {
+            const uint32_t num = pins[i].get_value();
+            if ((pin_bit_mask & (1ULL << num)) != 0u) {
+                throw GPIOException(ESP_ERR_INVALID_ARG);
+            }
+            pin_bit_mask |= 1ULL << num;
+            pin_masks[i] = gpio_reg::pin_mask(num);
+            bank_masks[pin_masks[i].bank] |= pin_masks[i].mask;
+        }
+
+        // Consecutive pins in ascending order in a single bank only need a shift
+        const uint32_t first = pins[0].get_value();
+        bool consecutive = (first % 32u) + N <= 32u;
+        for (std::size_t i = 1u; consecutive && i < N; i++) {
+            consecutive = pins[i].get_value() == first + i;
+        }
+        if (consecutive) {
+            shift = static_cast<int>(first % 32u);
+        }
+
+        configure_gpio_outputs(pin_bit_mask);
+    }
+
+    /**
+     * @brief Drive each pin of the bus to the level of the corresponding bit of \c value.
+     *
+     * The pins of a bank all change with one store of its output register, see gpio_reg::write_bits().
+     * Bits above N are ignored.
+     */
+    void write(uint32_t value) const noexcept
+    {
+        if (shift >= 0) {
+            const uint32_t bank = pin_masks[0].bank;
+            gpio_reg::write_bits(bank, bank_masks[bank], value << shift);
+            return;
+        }
+
+        const std::array<uint32_t, gpio_reg::BANK_COUNT> set = to_bank_masks(value);
+        for (uint32_t bank = 0u; bank < gpio_reg::BANK_COUNT; bank++) {
+            if (bank_masks[bank] != 0u) {
+                gpio_reg::write_bits(bank, bank_masks[bank], set[bank]);
+            }
+        }
+    }
+
+    /**
+     * @brief Drive to high level the pins of the bus whose bit is set in \c bits, leave the others unchanged.
+     */
+    void set_bits(uint32_t bits) const noexcept
+    {
+        const std::array<uint32_t, gpio_reg::BANK_COUNT> set = to_bank_masks(bits);
+        for (uint32_t bank = 0u; bank < gpio_reg::BANK_COUNT; bank++) {
+            if (set[bank] != 0u) {
+                gpio_reg::set_bits(bank, set[bank]);
+            }
+        }
+    }
+
+    /**
+     * @brief Drive to low level the pins of the bus whose bit is set in \c bits, leave the others unchanged.
+     */
+    void clear_bits(uint32_t bits) const noexcept
+    {
+        const std::array<uint32_t, gpio_reg::BANK_COUNT> clear = to_bank_masks(bits);
+        for (uint32_t bank = 0u; bank < gpio_reg::BANK_COUNT; bank++) {
+            if (clear[bank] != 0u) {
+                gpio_reg::clear_bits(bank, clear[bank]);
+            }
+        }
+    }
+
+    /**
+     * @brief Return the value currently driven on the bus.
+     */
+    uint32_t read_output() const noexcept
+    {
+        uint32_t value = 0u;
+        for (std::size_t i = 0u; i < N; i++) {
+            if ((gpio_reg::read_output(pin_masks[i].bank) & pin_masks[i].mask) != 0u) {
+                value |= 1u << i;
+            }
+        }
+        return value;
+    }
+
+private:
+    std::array<uint32_t, gpio_reg::BANK_COUNT> to_bank_masks(uint32_t value) const noexcept
+    {
+        std::array<uint32_t, gpio_reg::BANK_COUNT> masks = {};
+        for (std::size_t i = 0u; i < N; i++) {
+            if ((value & (1u << i)) != 0u) {
+                masks[pin_masks[i].bank] |= pin_masks[i].mask;
+            }
+        }
+        return masks;
+    }
+
+    /**
+     * Register location of each pin, indexed by bit number.
+     */
+    std::array<gpio_reg::PinMask, N> pin_masks;
+
+    /**
+     * All the pins of the bus for each bank.
+     */
+    std::array<uint32_t, gpio_reg::BANK_COUNT> bank_masks;
+
+    /**
+     * Position of bit 0 in its bank if the pins are consecutive, -1 otherwise.
+     */
+    int shift;
+};
+
+template<std::size_t N>
+GPIOBus(const std::array<GPIONum, N> &) -> GPIOBus<N>;
+
 }
 
 #endif
@@ -0,0 +1,91 @@
+#pragma once
+
+#if __cpp_exceptions
+
+#include "esp_timer_cxx.hpp"
+#include "gpio_cxx.hpp"
+#include "gpio_reg_cxx.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+namespace idf {
+
+/**
+ * @brief Debounce a group of input pins with a single periodic sampler.
+ *
+ * All the pins are sampled together by reading the input registers from one periodic esp_timer. Each pin has a 2-bit
+ * counter of consecutive samples differing from its debounced level. The counters of all the pins are stored
+ * "vertically", one bit plane per counter bit, and updated with a few bitwise operations per 32 pins bank. So a tick
+ * costs the same whatever the number of pins. A pin changes its debounced level after 4 consecutive identical
+ * samples, so the debounce time is 4 sample periods.
+ *
+ * Only the changes of the debounced levels are reported, from the esp_timer task.
+ */
+class GPIODebounceGroup {
+public:
+    /**
+     * @brief Number of consecutive identical samples needed to change a debounced level.
+     */
+    static constexpr uint32_t SAMPLE_COUNT = 4u;
+
+    /**
+     * @brief Called from the esp_timer task for each pin which changed its debounced level.
+     */
+    using CallBack = std::function<void(GPIONum num, bool level)>;
+
+    /**
+     * @brief Configure the pins as inputs with a single driver call and start sampling them.
+     *
+     * The debounced levels start with the current levels of the pins, no change is reported for them.
+     *
+     * @param pins The debounced pins.
+     * @param callback Called for each change of a debounced level.
+     * @param sample_period The period between two samples.
+     * @param pull_mode The pull mode of all the pins.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_ARG if a pin is used twice
+     *              - if the underlying driver function fails
+     * @throws ESPException if the timer can't be created or started
+     */
+    GPIODebounceGroup(std::span<const GPIONum> pins,
+            CallBack callback,
+            std::chrono::microseconds sample_period = std::chrono::milliseconds(5),
+            GPIOPullMode pull_mode = GPIOPullMode::FLOATING());
+
+    /**
+     * @brief Return the debounced level of a pin.
+     *
+     * @note Pins which are not in the group are read as low.
+     */
+    bool get_level(GPIONum num) const noexcept;
+
+private:
+    GPIODebounceGroup(const GPIODebounceGroup &) = delete;
+    GPIODebounceGroup & operator=(const GPIODebounceGroup &) = delete;
+
+    /**
+     * @brief Debounce state of the pins of one register bank, one bit per pin.
+     */
+    struct Bank {
+        uint32_t mask;
+        uint32_t count0;
+        uint32_t count1;
+        std::atomic<uint32_t> level;
+    };
+
+    void sample();
+
+    CallBack _callback;
+    std::array<Bank, gpio_reg::BANK_COUNT> _banks;
+    // Last member so that the timer is deleted before the state it uses
+    esp_timer::ESPTimer _timer;
+};
+
+} // idf
+
+#endif
@@ -0,0 +1,167 @@
+#pragma once
+
+#if __cpp_exceptions
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "gpio_cxx.hpp"
+#include "gpio_reg_cxx.hpp"
+#include "spsc_ring_cxx.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace idf {
+
+/**
+ * @brief An edge recorded by GPIOEdgeRecorder
+ */
+struct GPIOEdge {
+    /**
+     * GPIO number of the pin
+     */
+    uint32_t pin;
+
+    /**
+     * Level of the pin read in the interrupt, after the edge
+     */
+    bool level;
+
+    /**
+     * Time of the interrupt in microseconds, as returned by esp_timer_get_time()
+     */
+    int64_t timestamp;
+};
+
+/**
+ * @brief Record the edges of several input pins, with their timestamp, from the GPIO interrupt
+ *
+ * The interrupt handler only reads the input register and the time, and copies the edge in a
+ * preallocated lock-free ring. A task then receives the edges by batches with receive(), which can
+ * be used to decode a signal (IR, 1-wire, ...) at a high edge rate.
+ *
+ * @note The pins are configured as inputs and their interrupt is handled by the GPIO ISR service,
+ *       so all the edges are recorded from the same interrupt and core, in order.
+ * @note If a pulse is shorter than the interrupt latency, the recorded level may already be the one
+ *       after the next edge.
+ * @note When the ring is full, the new edges are dropped and counted, see dropped().
+ *
+ * @tparam Capacity Maximum number of edges waiting to be received, must be a power of two
+ * @tparam PinCount Number of recorded pins
+ */
+template <std::size_t Capacity, std::size_t PinCount>
+class GPIOEdgeRecorder
+{
+    static_assert(PinCount > 0u, "GPIOEdgeRecorder needs at least one pin");
+
+public:
+    /**
+     * @brief Configure the pins as inputs and start recording their edges
+     *
+     * @param pins The recorded pins.
+     * @param intType GPIO interrupt type, must not be GPIO_INTR_DISABLE.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_ARG if intType is GPIO_INTR_DISABLE
+     *              - if the underlying driver function fails
+     */
+    explicit GPIOEdgeRecorder(const std::array<GPIONum, PinCount> & pins, gpio_int_type_t intType = GPIO_INTR_ANYEDGE)
+        : _ring()
+        , _dropped(0u)
+        , _channels()
+    {
+        for (std::size_t i = 0u; i < PinCount; i++) {
+            Channel & channel = _channels[i];
+            channel.recorder = this;
+            channel.pin = pins[i].get_value();
+            channel.pin_mask = gpio_reg::pin_mask(channel.pin);
+            channel.input.emplace(pins[i]);
+            channel.input->template on_edge<&GPIOEdgeRecorder::record>(&channel, intType);
+        }
+    }
+
+    /**
+     * @brief Receive the recorded edges, oldest first
+     *
+     * Block until at least one edge is recorded, then copy as many edges as available and fitting
+     * in the given span.
+     *
+     * @warning This function uses the notification value of the calling task to wait, and must not
+     *          be called from an interrupt service routine. Only one task may receive at a time.
+     *
+     * @param edges Where to copy the edges.
+     * @param ticksToWait The maximum amount of time the task should block waiting for an edge. The
+     *        time is defined in tick periods so the constant portTICK_PERIOD_MS should be used to
+     *        convert to real time if this is required.
+     * @return The number of edges copied, 0 on timeout.
+     */
+    std::size_t receive(std::span<GPIOEdge> edges, TickType_t ticksToWait)
+    {
+        if (edges.empty())
+            return 0u;
+        std::optional<GPIOEdge> edge = _ring.pop(ticksToWait);
+        std::size_t count = 0u;
+        while (edge.has_value()) {
+            edges[count++] = *edge;
+            if (count == edges.size())
+                break;
+            edge = _ring.popFromISR();
+        }
+        return count;
+    }
+
+    /**
+     * @brief Return the number of edges dropped because the ring was full
+     */
+    uint32_t dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Return the input of a recorded pin, to set its pull mode for example
+     *
+     * @param index The index of the pin in the constructor argument.
+     */
+    GPIOInput & input(std::size_t index)
+    {
+        return *_channels[index].input;
+    }
+
+private:
+    GPIOEdgeRecorder(const GPIOEdgeRecorder &) = delete;
+    GPIOEdgeRecorder & operator=(const GPIOEdgeRecorder &) = delete;
+
+    struct Channel {
+        GPIOEdgeRecorder * recorder;
+        uint32_t pin;
+        gpio_reg::PinMask pin_mask;
+        std::optional<GPIOInput> input;
+    };
+
+    static void IRAM_ATTR record(Channel * channel)
+    {
+        GPIOEdgeRecorder * recorder = channel->recorder;
+        const GPIOEdge edge{
+            channel->pin,
+            (gpio_reg::read_input(channel->pin_mask.bank) & channel->pin_mask.mask) != 0u,
+            esp_timer_get_time()};
+        bool higherPriorityTaskWoken = false;
+        if (!recorder->_ring.pushFromISR(edge, higherPriorityTaskWoken))
+            recorder->_dropped.fetch_add(1u, std::memory_order_relaxed);
+        if (higherPriorityTaskWoken)
+            portYIELD_FROM_ISR();
+    }
+
+    SpscRing<GPIOEdge, Capacity> _ring;
+    std::atomic<uint32_t> _dropped;
+    // Last member so that the interrupts are removed before the ring is destroyed
+    std::array<Channel, PinCount> _channels;
+};
+
+} // idf
+
+#endif
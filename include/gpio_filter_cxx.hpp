@@ -0,0 +1,126 @@
+#pragma once
+
+#if __cpp_exceptions
+
+#include "sdkconfig.h"
+#include "esp_idf_version.h"
+#include "gpio_cxx.hpp"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "soc/soc_caps.h"
+#endif
+
+// The glitch filter driver is available since ESP-IDF v5.1
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0) \
+        && (SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER || SOC_GPIO_FLEX_GLITCH_FILTER_NUM > 0)
+#define GPIO_GLITCH_FILTER_CXX_SUPPORTED 1
+
+#include "driver/gpio_filter.h"
+#include <chrono>
+
+namespace idf {
+
+/**
+ * @brief Hardware glitch filter of a GPIO input, the pulses it removes never reach the GPIO matrix nor the
+ *        interrupt controller.
+ *
+ * The filter is created and enabled by the sub class constructor, disabled and deleted by the destructor.
+ */
+class GPIOGlitchFilter {
+public:
+    /**
+     * @brief Disable and delete the filter.
+     */
+    virtual ~GPIOGlitchFilter();
+
+    /**
+     * @brief Enable the filter.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_STATE if the filter is already enabled
+     */
+    void enable();
+
+    /**
+     * @brief Disable the filter.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_STATE if the filter is not enabled
+     */
+    void disable();
+
+    /**
+     * @brief Return true if the filter is enabled.
+     */
+    bool is_enabled() const noexcept;
+
+protected:
+    /**
+     * @brief Take the ownership of a created filter and enable it.
+     *
+     * @throws GPIOException if enabling the filter fails, the filter is then deleted.
+     */
+    explicit GPIOGlitchFilter(gpio_glitch_filter_handle_t handle);
+
+private:
+    GPIOGlitchFilter(const GPIOGlitchFilter &) = delete;
+    GPIOGlitchFilter & operator=(const GPIOGlitchFilter &) = delete;
+
+    gpio_glitch_filter_handle_t _handle;
+    bool _enabled;
+};
+
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+
+/**
+ * @brief Pin glitch filter, removes the pulses shorter than two clock cycles of the IO MUX.
+ */
+class GPIOPinGlitchFilter : public GPIOGlitchFilter {
+public:
+    /**
+     * @brief Create and enable the pin glitch filter of an input.
+     *
+     * @param input The filtered input.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_NO_MEM if out of memory
+     *              - if the underlying driver function fails
+     */
+    explicit GPIOPinGlitchFilter(const GPIOInput & input);
+};
+
+#endif // SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+
+#if SOC_GPIO_FLEX_GLITCH_FILTER_NUM > 0
+
+/**
+ * @brief Flexible glitch filter, removes the pulses shorter than a configurable threshold within a sliding window.
+ *
+ * @note There are only SOC_GPIO_FLEX_GLITCH_FILTER_NUM flexible filters for all the pins.
+ */
+class GPIOFlexGlitchFilter : public GPIOGlitchFilter {
+public:
+    /**
+     * @brief Create and enable a flexible glitch filter on an input.
+     *
+     * @param input The filtered input.
+     * @param window_width The width of the sliding sample window.
+     * @param window_threshold A pulse is removed if it lasts less than this time within the window, must not be
+     *        greater than window_width.
+     *
+     * @throws GPIOException
+     *              - ESP_ERR_INVALID_ARG if window_threshold is greater than window_width
+     *              - ESP_ERR_NOT_FOUND if all the flexible filters are used
+     *              - if the underlying driver function fails
+     */
+    GPIOFlexGlitchFilter(const GPIOInput & input,
+            std::chrono::nanoseconds window_width,
+            std::chrono::nanoseconds window_threshold);
+};
+
+#endif // SOC_GPIO_FLEX_GLITCH_FILTER_NUM > 0
+
+} // idf
+
+#endif // GPIO_GLITCH_FILTER_CXX_SUPPORTED
+
+#endif
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "sdkconfig.h"
+#include "hal/gpio_types.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <atomic>
+#else
+#include "freertos/FreeRTOS.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+#include "soc/gpio_reg.h"
+#endif
+
+/**
+ * Direct access to the GPIO input and output registers, bypassing the GPIO driver.
+ *
+ * Pins are grouped in banks of 32 pins, each bank has its own write-1-to-set (W1TS) and write-1-to-clear (W1TC)
+ * output registers. Writing a mask to one of them changes all the pins of the mask at the same time without
+ * disturbing the other pins, so no read-modify-write nor lock is needed. write_bits() instead drives pins both high
+ * and low with a single store of the output register, so it is a read-modify-write under a critical section.
+ * On the linux target, the registers are simulated by an array of atomics which tests can inspect and drive.
+ *
+ * @note The pins must already be configured by the GPIO driver, these functions don't do any check.
+ */
+namespace idf::gpio_reg {
+
+/**
+ * Number of 32 pins banks.
+ */
+constexpr std::size_t BANK_COUNT = (GPIO_NUM_MAX + 31u) / 32u;
+
+/**
+ * Location of a pin in the registers.
+ */
+struct PinMask {
+    uint32_t bank;
+    uint32_t mask;
+};
+
+constexpr PinMask pin_mask(uint32_t pin_num)
+{
+    return PinMask{pin_num / 32u, 1u << (pin_num % 32u)};
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+
+struct SimulatedRegisters {
+    std::array<std::atomic<uint32_t>, BANK_COUNT> out;
+    std::array<std::atomic<uint32_t>, BANK_COUNT> in;
+    // Number of stores to the output registers of each bank, so that tests can check when pins change together
+    std::array<std::atomic<uint32_t>, BANK_COUNT> out_store_count;
+};
+
+/**
+ * Register file used instead of the hardware on the linux target.
+ */
+extern SimulatedRegisters simulated_registers;
+
+inline void set_bits(uint32_t bank, uint32_t mask) noexcept
+{
+    simulated_registers.out[bank].fetch_or(mask, std::memory_order_relaxed);
+    simulated_registers.out_store_count[bank].fetch_add(1u, std::memory_order_relaxed);
+}
+
+inline void clear_bits(uint32_t bank, uint32_t mask) noexcept
+{
+    simulated_registers.out[bank].fetch_and(~mask, std::memory_order_relaxed);
+    simulated_registers.out_store_count[bank].fetch_add(1u, std::memory_order_relaxed);
+}
+
+inline void write_bits(uint32_t bank, uint32_t mask, uint32_t value) noexcept
+{
+    uint32_t out = simulated_registers.out[bank].load(std::memory_order_relaxed);
+    while (!simulated_registers.out[bank].compare_exchange_weak(out, (out & ~mask) | (value & mask),
+            std::memory_order_relaxed)) { }
+    simulated_registers.out_store_count[bank].fetch_add(1u, std::memory_order_relaxed);
+}
+
+inline uint32_t read_output(uint32_t bank) noexcept
+{
+    return simulated_registers.out[bank].load(std::memory_order_relaxed);
+}
+
+inline uint32_t read_input(uint32_t bank) noexcept
+{
+    return simulated_registers.in[bank].load(std::memory_order_relaxed);
+}
+
+#else
+
+inline void set_bits(uint32_t bank, uint32_t mask) noexcept
+{
+#if SOC_GPIO_PIN_COUNT > 32
+    if (bank != 0u) {
+        REG_WRITE(GPIO_OUT1_W1TS_REG, mask);
+        return;
+    }
+#endif
+    REG_WRITE(GPIO_OUT_W1TS_REG, mask);
+}
+
+inline void clear_bits(uint32_t bank, uint32_t mask) noexcept
+{
+#if SOC_GPIO_PIN_COUNT > 32
+    if (bank != 0u) {
+        REG_WRITE(GPIO_OUT1_W1TC_REG, mask);
+        return;
+    }
+#endif
+    REG_WRITE(GPIO_OUT_W1TC_REG, mask);
+}
+
+inline uint32_t read_output(uint32_t bank) noexcept
+{
+#if SOC_GPIO_PIN_COUNT > 32
+    if (bank != 0u)
+        return REG_READ(GPIO_OUT1_REG);
+#endif
+    return REG_READ(GPIO_OUT_REG);
+}
+
+/**
+ * Serializes the read-modify-writes of write_bits() between the cores and with the ISRs.
+ */
+inline portMUX_TYPE output_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * Drive the pins of \c mask to the levels of the corresponding bits of \c value, with a single store of the output
+ * register of the bank so that they all change at the same time.
+ *
+ * @note The other pins of the bank are written back with the level read before the store. A level set meanwhile by
+ *       a W1TS or W1TC write from the other core, e.g. by gpio_set_level(), is lost.
+ */
+inline void write_bits(uint32_t bank, uint32_t mask, uint32_t value) noexcept
+{
+    portENTER_CRITICAL_SAFE(&output_lock);
+    const uint32_t out = (read_output(bank) & ~mask) | (value & mask);
+#if SOC_GPIO_PIN_COUNT > 32
+    if (bank != 0u) {
+        REG_WRITE(GPIO_OUT1_REG, out);
+        portEXIT_CRITICAL_SAFE(&output_lock);
+        return;
+    }
+#endif
+    REG_WRITE(GPIO_OUT_REG, out);
+    portEXIT_CRITICAL_SAFE(&output_lock);
+}
+
+inline uint32_t read_input(uint32_t bank) noexcept
+{
+#if SOC_GPIO_PIN_COUNT > 32
+    if (bank != 0u)
+        return REG_READ(GPIO_IN1_REG);
+#endif
+    return REG_READ(GPIO_IN_REG);
+}
+
+#endif
+
+} // idf::gpio_reg
@@ -2,8 +2,14 @@
 
 #ifdef __cpp_exceptions
 
+#include <driver/gptimer.h>
 #include <driver/gptimer_types.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <ratio>
+#include "esp_exception.hpp"
 
 namespace idf {
 
@@ -226,11 +232,82 @@ private:
     GpTimer(const GpTimer &) = delete;
     GpTimer & operator=(const GpTimer &) = delete;
 
+    template<uint32_t ResolutionHz>
+    friend class GpTimerClock;
+
     gptimer_handle_t _gptimer;
     State _state;
     EventCallBack _callback;
 };
 
+/**
+ * @brief High resolution clock reading the raw count of a GpTimer, meeting the TrivialClock requirements of the
+ *        standard library
+ *
+ * One tick of the clock is one count of the timer, so no conversion is done when reading it and the durations
+ * between time points keep the full resolution of the timer. The clock must be attached to a timer whose resolution
+ * is ResolutionHz, counting up and started. Until then, and if the timer is not running, the clock stays at the epoch.
+ *
+ * @note The clock is steady only if the raw count of its timer is never set, so is_steady is false.
+ * @note now() is allowed to run within ISR context, see `GpTimer::getRawCount`. It is not an inline register read:
+ *       it calls gptimer_get_raw_count(), which takes the spinlock of the timer and triggers a software capture.
+ *
+ * @tparam ResolutionHz Resolution of the timer, in Hz
+ */
+template<uint32_t ResolutionHz>
+class GpTimerClock
+{
+public:
+    using rep = int64_t;
+    using period = std::ratio<1, ResolutionHz>;
+    using duration = std::chrono::duration<rep, period>;
+    using time_point = std::chrono::time_point<GpTimerClock>;
+
+    static constexpr bool is_steady = false;
+
+    /**
+     * @brief Attach the clock to a timer
+     *
+     * @note The timer must outlive its use by the clock, see `detach`.
+     *
+     * @param[in] timer Timer read by the clock
+     *
+     * @throw
+     *      - idf::ESPException(ESP_ERR_INVALID_ARG) if the resolution of the timer is not ResolutionHz
+     *      - idf::ESPException(ESP_FAIL) if other error
+     */
+    static void attach(const GpTimer & timer)
+    {
+        if (timer.getResolution() != ResolutionHz)
+            throw ESPException(ESP_ERR_INVALID_ARG);
+        _source.store(timer._gptimer, std::memory_order_release);
+    }
+
+    /**
+     * @brief Detach the clock from its timer, it then stays at the epoch
+     */
+    static void detach() noexcept
+    {
+        _source.store(nullptr, std::memory_order_release);
+    }
+
+    /**
+     * @brief Return the current raw count of the attached timer as a time point
+     */
+    static time_point now() noexcept
+    {
+        uint64_t count = 0u;
+        gptimer_handle_t source = _source.load(std::memory_order_acquire);
+        if (source != nullptr)
+            gptimer_get_raw_count(source, &count);
+        return time_point(duration(static_cast<rep>(count)));
+    }
+
+private:
+    // Written by attach() and detach() from a task, read by now() possibly from an ISR
+    static inline std::atomic<gptimer_handle_t> _source{nullptr};
+};
+
 } // idf
 
 #endif // __cpp_exceptions
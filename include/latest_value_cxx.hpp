@@ -0,0 +1,237 @@
+#pragma once
+
+#ifdef __cpp_exceptions
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+#if CONFIG_IDF_TARGET_LINUX
+#include <functional>
+#endif
+
+namespace idf {
+
+/**
+ * @brief Mailbox holding only the latest written value
+ *
+ * Writers overwrite the value, readers always get the most recent complete one. Unlike a Queue of
+ * length one used with Queue::overwrite() and Queue::peek(), reading never calls the kernel.
+ *
+ * The value is protected by a sequence counter, odd while a write is in progress. A reader copies the
+ * value and retries if the counter was odd or changed during its copy. The value is copied word by word
+ * with relaxed atomic accesses, so a copy racing with a write is well defined, only discarded.
+ * Writers are serialized by a spinlock, which also masks the interrupts of their core, so a write is
+ * never preempted and readers on another core only spin for the duration of a copy. Writers can be
+ * tasks or ISRs on any core.
+ *
+ * @tparam T Type of the value, must be trivially copyable and default constructible
+ */
+template <typename T>
+class LatestValue
+{
+    static_assert(std::is_trivially_copyable_v<T>, "LatestValue needs a trivially copyable type");
+    static_assert(std::is_default_constructible_v<T>, "LatestValue needs a default constructible type");
+
+public:
+    /**
+     * @param initial The value returned by read() before the first write, with version 0.
+     */
+    explicit LatestValue(const T & initial = T())
+        : _sequence(0u)
+        , _waitingTask(nullptr)
+        , _words()
+        , _writeLock portMUX_INITIALIZER_UNLOCKED
+    {
+        storeWords(initial);
+    }
+
+    /**
+     * @brief Replace the value from a task
+     */
+    void write(const T & value)
+    {
+        store(value);
+        TaskHandle_t waitingTask = takeWaitingTask();
+        if (waitingTask != nullptr)
+            xTaskNotifyGive(waitingTask);
+    }
+
+    /**
+     * @brief Replace the value from an interrupt service routine
+     *
+     * @param value The new value.
+     * @param[out] higherPriorityTaskWoken set to true if writing unblocked a task waiting in
+     *             waitForChange(), and this task has a priority higher than the currently running
+     *             task. If set to true a context switch should be requested before the interrupt is
+     *             exited.
+     */
+    void writeFromISR(const T & value, bool & higherPriorityTaskWoken)
+    {
+        store(value);
+        TaskHandle_t waitingTask = takeWaitingTask();
+        if (waitingTask != nullptr) {
+            BaseType_t temp = pdFALSE;
+            vTaskNotifyGiveFromISR(waitingTask, &temp);
+            if (temp == pdTRUE)
+                higherPriorityTaskWoken = true;
+        }
+    }
+
+    /**
+     * @brief Return a copy of the latest value
+     *
+     * @note This function never calls the kernel and can be called from a task or an ISR.
+     */
+    T read() const
+    {
+        uint32_t version;
+        return read(version);
+    }
+
+    /**
+     * @brief Return a copy of the latest value and its version
+     *
+     * @param[out] version The number of writes made before this value, to be given to waitForChange().
+     */
+    T read(uint32_t & version) const
+    {
+        while (true) {
+            const uint32_t before = _sequence.load(std::memory_order_acquire);
+#if CONFIG_IDF_TARGET_LINUX
+            if (_readHook)
+                _readHook();
+#endif
+            if ((before & 1u) != 0u)
+                continue;
+            T value = loadWords();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_sequence.load(std::memory_order_relaxed) == before) {
+                version = before / 2u;
+                return value;
+            }
+        }
+    }
+
+    /**
+     * @brief Return the number of writes made so far
+     */
+    uint32_t version() const
+    {
+        return _sequence.load(std::memory_order_acquire) / 2u;
+    }
+
+    /**
+     * @brief Block until the value is written again
+     *
+     * @warning Only one task may wait at a time. This function uses the notification value of the
+     *          calling task and must not be called from an interrupt service routine.
+     *
+     * @param[in,out] version The version of the last value known by the caller, as returned by read().
+     *                Updated with the version of the returned value.
+     * @param ticksToWait The maximum amount of time the task should block waiting for a newer value.
+     *        The time is defined in tick periods so the constant portTICK_PERIOD_MS should be used to
+     *        convert to real time if this is required.
+     * @return The latest value if it is newer than version, nothing on timeout.
+     */
+    std::optional<T> waitForChange(uint32_t & version, TickType_t ticksToWait)
+    {
+        TimeOut_t timeOut;
+        vTaskSetTimeOutState(&timeOut);
+        while (true) {
+            _waitingTask.store(xTaskGetCurrentTaskHandle(), std::memory_order_seq_cst);
+            if (_sequence.load(std::memory_order_seq_cst) / 2u != version) {
+                _waitingTask.store(nullptr, std::memory_order_relaxed);
+                return read(version);
+            }
+            if (ticksToWait == 0 || xTaskCheckForTimeOut(&timeOut, &ticksToWait) == pdTRUE) {
+                _waitingTask.store(nullptr, std::memory_order_relaxed);
+                return {};
+            }
+            ulTaskNotifyTake(pdTRUE, ticksToWait);
+        }
+    }
+
+private:
+    LatestValue(const LatestValue &) = delete;
+    LatestValue & operator=(const LatestValue &) = delete;
+
+    static constexpr std::size_t WORD_COUNT = (sizeof(T) + sizeof(uint32_t) - 1u) / sizeof(uint32_t);
+
+    void store(const T & value)
+    {
+        portENTER_CRITICAL_SAFE(&_writeLock);
+        const uint32_t sequence = beginWrite();
+        storeWords(value);
+        endWrite(sequence);
+        portEXIT_CRITICAL_SAFE(&_writeLock);
+    }
+
+    /**
+     * Make the sequence odd, return its previous value to be given to endWrite().
+     */
+    uint32_t beginWrite()
+    {
+        const uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1u, std::memory_order_relaxed);
+        // Orders the odd sequence before the words, a reader seeing any new word then sees a changed sequence
+        std::atomic_thread_fence(std::memory_order_release);
+        return sequence;
+    }
+
+    /**
+     * Publish the words stored since beginWrite(), the sequence is even again.
+     */
+    void endWrite(uint32_t sequence)
+    {
+        _sequence.store(sequence + 2u, std::memory_order_seq_cst);
+    }
+
+    void storeWords(const T & value)
+    {
+        std::array<uint32_t, WORD_COUNT> words = {};
+        std::memcpy(words.data(), &value, sizeof(T));
+        for (std::size_t i = 0u; i < WORD_COUNT; i++)
+            _words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    T loadWords() const
+    {
+        std::array<uint32_t, WORD_COUNT> words;
+        for (std::size_t i = 0u; i < WORD_COUNT; i++)
+            words[i] = _words[i].load(std::memory_order_relaxed);
+        T value;
+        std::memcpy(&value, words.data(), sizeof(T));
+        return value;
+    }
+
+    TaskHandle_t takeWaitingTask()
+    {
+        if (_waitingTask.load(std::memory_order_seq_cst) == nullptr)
+            return nullptr;
+        return _waitingTask.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    std::atomic<uint32_t> _sequence;
+    std::atomic<TaskHandle_t> _waitingTask;
+    std::array<std::atomic<uint32_t>, WORD_COUNT> _words;
+    portMUX_TYPE _writeLock;
+
+#if CONFIG_IDF_TARGET_LINUX
+    /**
+     * Called by read() after each load of the sequence, so that the host tests can interleave a write with a read.
+     */
+    std::function<void()> _readHook;
+
+    friend struct LatestValueTest;
+#endif
+};
+
+} // idf
+
+#endif // __cpp_exceptions
@@ -0,0 +1,523 @@
+#pragma once
+
+#ifdef __cpp_exceptions
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "esp_event_cxx.hpp"
+
+namespace idf {
+
+namespace event {
+
+namespace local_bus_detail {
+
+template<typename T>
+struct HandlerOf {
+    using type = std::function<void(const T &)>;
+};
+
+template<>
+struct HandlerOf<void> {
+    using type = std::function<void()>;
+};
+
+} // local_bus_detail
+
+/**
+ * @brief
+ * An event of a LocalBus, identified at compile time.
+ *
+ * @tparam ID The event ID, unique on a bus.
+ * @tparam T The type of the event data, void for events without data. The data is copied when the event is queued,
+ *           so it must be trivially copyable.
+ *
+ * Example: \c using SensorUpdate = LocalEvent<0, SensorReading>;
+ */
+template<int32_t ID, typename T = void>
+struct LocalEvent {
+    static_assert(std::is_void_v<T> || std::is_trivially_copyable_v<T>, "LocalEvent data must be trivially copyable");
+
+    static constexpr int32_t id = ID;
+
+    using DataType = T;
+
+    /**
+     * Handler receiving the event data as a \c const T&, or nothing for events without data.
+     */
+    using Handler = typename local_bus_detail::HandlerOf<T>::type;
+};
+
+/**
+ * @brief
+ * Registration of a handler on a LocalBus, the handler is unregistered by the destructor.
+ *
+ * After the destructor returns, the handler isn't called anymore, unless the destructor is called from the handler
+ * itself. The registration must not outlive its bus.
+ */
+class LocalBusReg {
+public:
+    virtual ~LocalBusReg() = default;
+
+protected:
+    LocalBusReg() = default;
+
+private:
+    LocalBusReg(const LocalBusReg&) = delete;
+    LocalBusReg &operator=(const LocalBusReg&) = delete;
+};
+
+/**
+ * @brief
+ * Publish/subscribe of intra-application events without esp_event.
+ *
+ * The set of events is fixed at compile time, and each event has its own flat table of handlers. So there is no
+ * lookup by base and ID, no trampoline through \c void* data, and nothing is allocated when posting. The API follows
+ * ESPEventLoop so that an event can be moved from one to the other by changing its declaration.
+ *
+ * An event can be dispatched in two ways:
+ *      - dispatch_event() calls the handlers synchronously in the calling task.
+ *      - post_event() copies the event data into a fixed size queue, and the handlers are called from the
+ *        dispatcher thread of the bus, like on an event loop.
+ *
+ * Handlers are called one at a time: the synchronous dispatches of several tasks and the dispatcher thread are
+ * serialized. A handler may post or dispatch events, register handlers and unregister handlers. Handlers registered
+ * during a dispatch are called from the next event.
+ *
+ * @tparam Events The LocalEvent types of the bus, with distinct IDs.
+ *
+ * @note The dispatcher thread is a std::thread, its stack size and priority are those of the pthread default
+ *       configuration, see \c esp_pthread_set_cfg().
+ */
+template<typename... Events>
+class LocalBus {
+    static_assert(sizeof...(Events) > 0, "LocalBus needs at least one event");
+
+    static constexpr bool ids_are_unique()
+    {
+        constexpr int32_t ids[] = {Events::id...};
+        for (std::size_t i = 0; i < sizeof...(Events); i++) {
+            for (std::size_t j = i + 1; j < sizeof...(Events); j++) {
+                if (ids[i] == ids[j]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static_assert(ids_are_unique(), "LocalBus event IDs must be unique");
+
+    template<typename Event>
+    static constexpr std::size_t index_of()
+    {
+        constexpr bool matches[] = {std::is_same_v<Event, Events>...};
+        for (std::size_t i = 0; i < sizeof...(Events); i++) {
+            if (matches[i]) {
+                return i;
+            }
+        }
+        return sizeof...(Events);
+    }
+
+    template<typename T>
+    static constexpr std::size_t size_of()
+    {
+        if constexpr (std::is_void_v<T>) {
+            return 1;
+        } else {
+            return sizeof(T);
+        }
+    }
+
+    template<typename T>
+    static constexpr std::size_t align_of()
+    {
+        if constexpr (std::is_void_v<T>) {
+            return 1;
+        } else {
+            return alignof(T);
+        }
+    }
+
+    static constexpr std::size_t DATA_SIZE = std::max({size_of<typename Events::DataType>()...});
+    static constexpr std::size_t DATA_ALIGN = std::max({align_of<typename Events::DataType>()...});
+
+public:
+    /**
+     * @param queue_size The number of events which can be queued by post_event(). If 0, there is no queue nor
+     *        dispatcher thread, and the bus only supports dispatch_event().
+     *
+     * @note may throw std::system_error if the dispatcher thread can't be created
+     */
+    explicit LocalBus(std::size_t queue_size = 32)
+        : table_mutex(),
+        tables(),
+        depth(0),
+        dirty(false),
+        next_key(0),
+        queue_size(queue_size),
+        queue_mutex(),
+        not_empty(),
+        not_full(),
+        items(queue_size == 0 ? 0 : queue_size + 1),
+        head(0),
+        count(0),
+        stopping(false),
+        thread()
+    {
+        if (queue_size != 0) {
+            thread = std::thread(&LocalBus::run, this);
+        }
+    }
+
+    /**
+     * @brief Stop the dispatcher thread, the events still queued are dropped.
+     */
+    ~LocalBus()
+    {
+        if (thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                stopping = true;
+            }
+            not_empty.notify_one();
+            not_full.notify_all();
+            thread.join();
+        }
+    }
+
+    /**
+     * Registers a handler of an event.
+     *
+     * @return the registration, the handler is unregistered when it is destroyed.
+     *
+     * @throws EventException with error ESP_ERR_INVALID_ARG if cb is empty.
+     */
+    template<typename Event>
+    std::unique_ptr<LocalBusReg> register_event(const Event &event, typename Event::Handler cb)
+    {
+        constexpr std::size_t index = checked_index<Event>();
+        if (!cb) {
+            throw EventException(ESP_ERR_INVALID_ARG);
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(table_mutex);
+        auto &table = std::get<index>(tables);
+        const uint32_t key = next_key++;
+        std::unique_ptr<LocalBusReg> reg(new Reg<index>(*this, key));
+        // Registering during a dispatch must not reallocate the entries which are being iterated
+        auto &entries = depth == 0 ? table.entries : table.added;
+        entries.push_back(Entry<Event>{key, true, std::move(cb)});
+        dirty = dirty || depth != 0;
+        return reg;
+    }
+
+    /**
+     * Posts an event and its data to the queue, the handlers are called from the dispatcher thread.
+     *
+     * @param event the event to post
+     * @param event_data The event data, copied into the queue.
+     * @param wait_time the maximum time to wait for room in the queue, PLATFORM_MAX_DELAY_MS waits forever.
+     *
+     * @throws EventException
+     *              - ESP_ERR_TIMEOUT if the queue stayed full during wait_time
+     *              - ESP_ERR_INVALID_STATE if the bus has no queue
+     *
+     * @note Like on an event loop, a handler posting with an infinite wait_time to a full queue never returns.
+     */
+    template<typename Event>
+    requires (!std::is_void_v<typename Event::DataType>)
+    void post_event(const Event &event,
+            const typename Event::DataType &event_data,
+            const std::chrono::milliseconds &wait_time = PLATFORM_MAX_DELAY_MS)
+    {
+        enqueue(wait_time, [&event_data](Item &item) {
+            item.index = checked_index<Event>();
+            ::new (static_cast<void*>(item.data)) typename Event::DataType(event_data);
+        });
+    }
+
+    /**
+     * Posts an event without data to the queue, the handlers are called from the dispatcher thread.
+     *
+     * @param event the event to post
+     * @param wait_time the maximum time to wait for room in the queue, PLATFORM_MAX_DELAY_MS waits forever.
+     *
+     * @throws EventException
+     *              - ESP_ERR_TIMEOUT if the queue stayed full during wait_time
+     *              - ESP_ERR_INVALID_STATE if the bus has no queue
+     */
+    template<typename Event>
+    requires (std::is_void_v<typename Event::DataType>)
+    void post_event(const Event &event,
+            const std::chrono::milliseconds &wait_time = PLATFORM_MAX_DELAY_MS)
+    {
+        enqueue(wait_time, [](Item &item) {
+            item.index = checked_index<Event>();
+        });
+    }
+
+    /**
+     * Calls the handlers of an event in the calling task, before returning.
+     *
+     * @param event the event to dispatch
+     * @param event_data The event data, given to the handlers without copy.
+     */
+    template<typename Event>
+    requires (!std::is_void_v<typename Event::DataType>)
+    void dispatch_event(const Event &event, const typename Event::DataType &event_data)
+    {
+        dispatch<checked_index<Event>()>(event_data);
+    }
+
+    /**
+     * Calls the handlers of an event without data in the calling task, before returning.
+     *
+     * @param event the event to dispatch
+     */
+    template<typename Event>
+    requires (std::is_void_v<typename Event::DataType>)
+    void dispatch_event(const Event &event)
+    {
+        dispatch<checked_index<Event>()>();
+    }
+
+private:
+    LocalBus(const LocalBus&) = delete;
+    LocalBus &operator=(const LocalBus&) = delete;
+
+    template<typename Event>
+    static constexpr std::size_t checked_index()
+    {
+        constexpr std::size_t index = index_of<Event>();
+        static_assert(index < sizeof...(Events), "The event is not an event of this LocalBus");
+        return index;
+    }
+
+    template<typename Event>
+    struct Entry {
+        uint32_t key;
+        bool active;
+        typename Event::Handler handler;
+    };
+
+    template<typename Event>
+    struct Table {
+        std::vector<Entry<Event>> entries;
+
+        /**
+         * Entries registered during a dispatch, moved to entries after it.
+         */
+        std::vector<Entry<Event>> added;
+    };
+
+    template<std::size_t Index>
+    class Reg : public LocalBusReg {
+    public:
+        Reg(LocalBus &bus, uint32_t key) : bus(bus), key(key) { }
+
+        ~Reg() override
+        {
+            bus.template unregister<Index>(key);
+        }
+
+    private:
+        LocalBus &bus;
+        const uint32_t key;
+    };
+
+    struct Item {
+        std::size_t index;
+        alignas(DATA_ALIGN) unsigned char data[DATA_SIZE];
+    };
+
+    /**
+     * Marks the end of a dispatch, also if a handler throws.
+     */
+    struct DispatchGuard {
+        explicit DispatchGuard(LocalBus &bus) : bus(bus)
+        {
+            bus.depth++;
+        }
+
+        ~DispatchGuard()
+        {
+            if (--bus.depth == 0 && bus.dirty) {
+                bus.cleanup(std::index_sequence_for<Events...>());
+            }
+        }
+
+        LocalBus &bus;
+    };
+
+    template<std::size_t Index>
+    void unregister(uint32_t key) noexcept
+    {
+        std::lock_guard<std::recursive_mutex> lock(table_mutex);
+        auto &table = std::get<Index>(tables);
+        for (auto *entries : {&table.entries, &table.added}) {
+            for (auto it = entries->begin(); it != entries->end(); ++it) {
+                if (it->key != key) {
+                    continue;
+                }
+                if (depth == 0) {
+                    entries->erase(it);
+                } else {
+                    // The handler may be running, it is destroyed after the dispatch
+                    it->active = false;
+                    dirty = true;
+                }
+                return;
+            }
+        }
+    }
+
+    template<std::size_t Index, typename... Data>
+    void dispatch(const Data &... event_data)
+    {
+        std::lock_guard<std::recursive_mutex> lock(table_mutex);
+        DispatchGuard guard(*this);
+        for (auto &entry : std::get<Index>(tables).entries) {
+            if (entry.active) {
+                entry.handler(event_data...);
+            }
+        }
+    }
+
+    template<std::size_t... Index>
+    void cleanup(std::index_sequence<Index...>)
+    {
+        (cleanup_table(std::get<Index>(tables)), ...);
+        dirty = false;
+    }
+
+    template<typename Event>
+    static void cleanup_table(Table<Event> &table)
+    {
+        std::erase_if(table.entries, [](const Entry<Event> &entry) { return !entry.active; });
+        for (auto &entry : table.added) {
+            if (entry.active) {
+                table.entries.push_back(std::move(entry));
+            }
+        }
+        table.added.clear();
+    }
+
+    /**
+     * Waits for a free item at the back of the queue, fills it and publishes it.
+     */
+    template<typename Fill>
+    void enqueue(const std::chrono::milliseconds &wait_time, Fill fill)
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        if (queue_size == 0) {
+            throw EventException(ESP_ERR_INVALID_STATE);
+        }
+
+        auto has_room = [this]() { return count < queue_size || stopping; };
+        if (wait_time == PLATFORM_MAX_DELAY_MS) {
+            not_full.wait(lock, has_room);
+        } else if (!not_full.wait_for(lock, wait_time, has_room)) {
+            throw EventException(ESP_ERR_TIMEOUT);
+        }
+        if (stopping) {
+            throw EventException(ESP_ERR_INVALID_STATE);
+        }
+
+        fill(items[(head + count) % items.size()]);
+        count++;
+        lock.unlock();
+        not_empty.notify_one();
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        while (true) {
+            not_empty.wait(lock, [this]() { return count != 0 || stopping; });
+            if (stopping) {
+                return;
+            }
+
+            // The ring has a spare item, so the posters can't reuse the popped item before the next pop and it is
+            // dispatched in place
+            const Item &item = items[head];
+            head = (head + 1) % items.size();
+            count--;
+            lock.unlock();
+            not_full.notify_one();
+
+            dispatch_item(item, std::index_sequence_for<Events...>());
+            lock.lock();
+        }
+    }
+
+    template<std::size_t... Index>
+    void dispatch_item(const Item &item, std::index_sequence<Index...>)
+    {
+        ((item.index == Index ? dispatch_item<Index>(item) : void()), ...);
+    }
+
+    template<std::size_t Index>
+    void dispatch_item(const Item &item)
+    {
+        using DataType = typename std::tuple_element_t<Index, std::tuple<Events...>>::DataType;
+        if constexpr (std::is_void_v<DataType>) {
+            dispatch<Index>();
+        } else {
+            dispatch<Index>(*std::launder(reinterpret_cast<const DataType*>(item.data)));
+        }
+    }
+
+    /**
+     * Protects the handler tables and the dispatch state, held during a dispatch.
+     */
+    std::recursive_mutex table_mutex;
+    std::tuple<Table<Events>...> tables;
+
+    /**
+     * Number of nested dispatches, the entries are only erased or added when it is 0.
+     */
+    uint32_t depth;
+    bool dirty;
+    uint32_t next_key;
+
+    const std::size_t queue_size;
+
+    /**
+     * Protects the following members.
+     */
+    std::mutex queue_mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+
+    /**
+     * Ring of queued events, count items starting at head. It has one more item than queue_size for the event being
+     * dispatched.
+     */
+    std::vector<Item> items;
+    std::size_t head;
+    std::size_t count;
+    bool stopping;
+
+    std::thread thread;
+};
+
+} // event
+
+} // idf
+
+#endif // __cpp_exceptions
@@ -5,10 +5,15 @@
 #include "esp_exception.hpp"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/task.h"
 #include <optional>
+#include <span>
 
 namespace idf {
 
+template <typename... Ts>
+class QueueSet;
+
 template <typename T>
 class Queue
 {
@@ -228,6 +233,67 @@ public:
         return true;
     }
 
+    /**
+     * @brief Post several items to the back of a queue.
+     *
+     * Only the first item may block. Once it has been posted, the scheduler is suspended while the
+     * remaining items are copied without waiting, so no other task runs between them. A task blocked
+     * on the queue is still woken by the first item, and may run before the others are posted if it
+     * has a higher priority than the calling task.
+     *
+     * @note On a multi-core target, vTaskSuspendAll() only suspends the scheduler of the calling core. A task
+     *       running on another core can receive items while the batch is being posted.
+     * @note The items are queued by copy, not by reference.
+     * @warning This function must not be called from an interrupt service routine. See
+     *          sendNFromISR() for an alternative which may be used in an ISR.
+     *
+     * @param items The items to place on the queue, in order.
+     * @param ticksToWait The maximum amount of time the task should block waiting for space for the
+     *        first item to become available on the queue, should it already be full. The time is
+     *        defined in tick periods so the constant portTICK_PERIOD_MS should be used to convert to
+     *        real time if this is required.
+     * @return The number of items posted, from the front of items. Less than items.size() if the
+     *         queue became full.
+     */
+    std::size_t sendN(std::span<const T> items, TickType_t ticksToWait)
+    {
+        if (items.empty())
+            return 0u;
+        if (xQueueSend(_handle, &items[0], ticksToWait) != pdTRUE)
+            return 0u;
+        std::size_t count = 1u;
+        vTaskSuspendAll();
+        while (count < items.size() && xQueueSend(_handle, &items[count], 0) == pdTRUE)
+            count++;
+        xTaskResumeAll();
+        return count;
+    }
+
+    /**
+     * @brief Post several items to the back of a queue from an interrupt service routine.
+     *
+     * Stop at the first item that does not fit.
+     *
+     * @note Items are queued by copy not reference so it is preferable to only queue small items.
+     *
+     * @param items The items to place on the queue, in order.
+     * @param[out] higherPriorityTaskWoken set to true if sending to the queue caused a task to
+     *             unblock, and the unblocked task has a priority higher than the currently running
+     *             task. A single context switch should then be requested before the interrupt is
+     *             exited, whatever the number of items posted.
+     * @return The number of items posted, from the front of items.
+     */
+    std::size_t sendNFromISR(std::span<const T> items, bool & higherPriorityTaskWoken)
+    {
+        BaseType_t temp = pdFALSE;
+        std::size_t count = 0u;
+        while (count < items.size() && xQueueSendFromISR(_handle, &items[count], &temp) == pdTRUE)
+            count++;
+        if (temp == pdTRUE)
+            higherPriorityTaskWoken = true;
+        return count;
+    }
+
     /**
      * @brief Post an item on a queue. If the queue is already full then overwrite the value held in the
      * queue.
@@ -244,7 +310,8 @@ public:
      */
     void overwrite(const T & itemToQueue)
     {
-        assert(xQueueOverwrite(_handle, itemToQueue) == pdPASS);
+        [[maybe_unused]] BaseType_t result = xQueueOverwrite(_handle, &itemToQueue);
+        assert(result == pdPASS);
     }
 
     /**
@@ -267,7 +334,8 @@ public:
     void overwriteFromISR(const T & itemToQueue, bool & higherPriorityTaskWoken)
     {
         BaseType_t temp = pdFALSE;
-        assert(xQueueOverwriteFromISR(_handle, &itemToQueue, &temp) == pdPASS);
+        [[maybe_unused]] BaseType_t result = xQueueOverwriteFromISR(_handle, &itemToQueue, &temp);
+        assert(result == pdPASS);
         if (temp == pdTRUE)
             higherPriorityTaskWoken = true;
     }
@@ -354,19 +422,85 @@ public:
         return value;
     }
 
+    /**
+     * @brief Receive several items from a queue.
+     *
+     * Block until at least min items have been received or ticksToWait expires. Each time the task
+     * is woken up, all the items already available are drained with the scheduler suspended, up to
+     * items.size().
+     *
+     * @note On a multi-core target, vTaskSuspendAll() only suspends the scheduler of the calling core. A task
+     *       running on another core can post items while they are drained, and they are then drained as well.
+     * @note Successfully received items are removed from the queue.
+     * @warning This function must not be used in an interrupt service routine. See
+     *          receiveNFromISR() for an alternative that can.
+     *
+     * @param[out] items Storage for the received items.
+     * @param min The number of items to wait for, clamped to items.size(). If 0 the function never
+     *        blocks and only returns the items already available.
+     * @param ticksToWait The maximum amount of time the task should block waiting for min items.
+     *        The time is defined in tick periods so the constant portTICK_PERIOD_MS should be used
+     *        to convert to real time if this is required.
+     * @return The number of items written at the front of items.
+     */
+    std::size_t receiveN(std::span<T> items, std::size_t min, TickType_t ticksToWait)
+    {
+        if (min == 0u)
+            ticksToWait = 0;
+        TimeOut_t timeOut;
+        vTaskSetTimeOutState(&timeOut);
+        std::size_t count = 0u;
+        while (count < items.size()) {
+            if (xQueueReceive(_handle, &items[count], ticksToWait) != pdTRUE)
+                break;
+            count++;
+            vTaskSuspendAll();
+            while (count < items.size() && xQueueReceive(_handle, &items[count], 0) == pdTRUE)
+                count++;
+            xTaskResumeAll();
+            if (count >= min || xTaskCheckForTimeOut(&timeOut, &ticksToWait) == pdTRUE)
+                break;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Receive several items from a queue from an interrupt service routine.
+     *
+     * @param[out] items Storage for the received items.
+     * @param[out] taskWokenByReceive A task may be blocked waiting for space to become available
+     *             on the queue. If receiveNFromISR causes such a task to unblock taskWokenByReceive
+     *             will get set to true, otherwise taskWokenByReceive will remain unchanged.
+     * @return The number of items written at the front of items.
+     */
+    std::size_t receiveNFromISR(std::span<T> items, bool * taskWokenByReceive = nullptr)
+    {
+        BaseType_t temp = pdFALSE;
+        std::size_t count = 0u;
+        while (count < items.size() && xQueueReceiveFromISR(_handle, &items[count], &temp) == pdTRUE)
+            count++;
+        if (taskWokenByReceive != nullptr && temp == pdTRUE)
+            *taskWokenByReceive = true;
+        return count;
+    }
+
     /**
      * @brief Reset a queue back to its original empty state.
      */
     void reset()
     {
         // The return value is now obsolete and is always set to pdPASS.
-        assert(xQueueReset(_handle) == pdPASS);
+        [[maybe_unused]] BaseType_t result = xQueueReset(_handle);
+        assert(result == pdPASS);
     }
 
 private:
     Queue(const Queue &) = delete;
     Queue & operator=(const Queue &) = delete;
 
+    template <typename... Ts>
+    friend class QueueSet;
+
     QueueHandle_t _handle;
 };
 
@@ -0,0 +1,160 @@
+#pragma once
+
+#ifdef __cpp_exceptions
+
+#include "esp_exception.hpp"
+#include "queue_cxx.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <array>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+namespace idf {
+
+/**
+ * @brief Group several queues, of possibly different item types, so that a single task can block
+ *        on all of them at once.
+ *
+ * @note A queue can only belong to one set, and must be empty when the set is created.
+ * @note Once in a set, items must only be received from a queue after it has been returned by
+ *       select(). receive() does both.
+ *
+ * @tparam Ts The item types of the queues, in the order they are given to the constructor.
+ */
+template <typename... Ts>
+class QueueSet
+{
+    static_assert(sizeof...(Ts) > 0u, "QueueSet needs at least one queue");
+
+public:
+    /**
+     * @brief Create a queue set and add the queues to it
+     *
+     * The length of the set is the sum of the lengths of the queues, so that it can never overflow.
+     *
+     * @param queues The queues to block on. They must outlive the set.
+     *
+     * @throw
+     *      - idf::ESPException(ESP_ERR_NO_MEM) if out of memory
+     *      - idf::ESPException(ESP_ERR_INVALID_STATE) if a queue is not empty or already in a set
+     */
+    explicit QueueSet(Queue<Ts> &... queues)
+        : _queues(queues...)
+        , _members{queues._handle...}
+    {
+        _handle = xQueueCreateSet((queues.spacesAvailable() + ...));
+        if (_handle == nullptr)
+            throw idf::ESPException(ESP_ERR_NO_MEM);
+        for (std::size_t i = 0u; i < _members.size(); i++) {
+            if (xQueueAddToSet(_members[i], _handle) != pdPASS) {
+                removeFromSet(i);
+                vQueueDelete(_handle);
+                throw idf::ESPException(ESP_ERR_INVALID_STATE);
+            }
+        }
+    }
+
+    /**
+     * @brief Remove the queues from the set and delete the set
+     *
+     * @note The queues must be empty, otherwise they stay bound to the deleted set.
+     */
+    ~QueueSet()
+    {
+        removeFromSet(_members.size());
+        vQueueDelete(_handle);
+    }
+
+    /**
+     * @brief Block until one of the queues contains an item
+     *
+     * @note The item is not removed, it must then be received from the queue with the returned index
+     *       with a ticksToWait of 0.
+     * @warning This function must not be called from an interrupt service routine.
+     *
+     * @param ticksToWait The maximum amount of time the task should block waiting for an item in any
+     *        of the queues. The time is defined in tick periods so the constant portTICK_PERIOD_MS
+     *        should be used to convert to real time if this is required.
+     * @return The index, in the constructor argument order, of the queue containing an item.
+     */
+    std::optional<std::size_t> select(TickType_t ticksToWait)
+    {
+        return indexOf(xQueueSelectFromSet(_handle, ticksToWait));
+    }
+
+    /**
+     * @brief A version of select() that can be called from an interrupt service routine
+     */
+    std::optional<std::size_t> selectFromISR()
+    {
+        return indexOf(xQueueSelectFromSetFromISR(_handle));
+    }
+
+    /**
+     * @brief Block until one of the queues contains an item, receive it and pass it to a visitor
+     *
+     * @warning This function must not be called from an interrupt service routine.
+     *
+     * @param visitor A callable accepting an item of each of the queue types, for example a lambda
+     *        with an auto parameter or a set of overloads.
+     * @param ticksToWait The maximum amount of time the task should block waiting for an item in any
+     *        of the queues. The time is defined in tick periods so the constant portTICK_PERIOD_MS
+     *        should be used to convert to real time if this is required.
+     * @return true if an item was received and visited, false on timeout.
+     */
+    template <typename Visitor>
+    bool receive(Visitor && visitor, TickType_t ticksToWait)
+    {
+        std::optional<std::size_t> index = select(ticksToWait);
+        if (!index.has_value())
+            return false;
+        return visit(*index, visitor, std::index_sequence_for<Ts...>());
+    }
+
+private:
+    QueueSet(const QueueSet &) = delete;
+    QueueSet & operator=(const QueueSet &) = delete;
+
+    std::optional<std::size_t> indexOf(QueueSetMemberHandle_t member) const
+    {
+        for (std::size_t i = 0u; i < _members.size(); i++) {
+            if (_members[i] == member)
+                return i;
+        }
+        return {};
+    }
+
+    void removeFromSet(std::size_t count)
+    {
+        for (std::size_t i = 0u; i < count; i++)
+            xQueueRemoveFromSet(_members[i], _handle);
+    }
+
+    template <typename Visitor, std::size_t... Is>
+    bool visit(std::size_t index, Visitor & visitor, std::index_sequence<Is...>)
+    {
+        bool received = false;
+        ((index == Is ? (received = visitOne<Is>(visitor)) : false) || ...);
+        return received;
+    }
+
+    template <std::size_t I, typename Visitor>
+    bool visitOne(Visitor & visitor)
+    {
+        auto item = std::get<I>(_queues).receive(0);
+        if (!item.has_value())
+            return false;
+        visitor(*item);
+        return true;
+    }
+
+    std::tuple<Queue<Ts> &...> _queues;
+    std::array<QueueSetMemberHandle_t, sizeof...(Ts)> _members;
+    QueueSetHandle_t _handle;
+};
+
+} // idf
+
+#endif // __cpp_exceptions
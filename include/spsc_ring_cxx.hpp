@@ -0,0 +1,205 @@
+#pragma once
+
+#ifdef __cpp_exceptions
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+namespace idf {
+
+/**
+ * @brief Lock-free ring buffer with a single producer and a single consumer
+ *
+ * Unlike Queue, pushing or popping an item never enters a critical section: the producer only writes
+ * the head index and the consumer only writes the tail index. The consumer can block in pop(), it is
+ * then woken by a direct to task notification from the producer.
+ *
+ * @note Only one task or ISR may push and only one task may pop at a time.
+ * @note Items are copied in and out of the ring, it is preferable to only use small trivially
+ *       copyable types.
+ *
+ * @tparam T Type of the items
+ * @tparam N Capacity of the ring, must be a power of two
+ */
+template <typename T, std::size_t N>
+class SpscRing
+{
+    static_assert(N > 0u && (N & (N - 1u)) == 0u, "SpscRing capacity must be a power of two");
+
+public:
+    /**
+     * @brief Size used to keep the producer and consumer indexes on different cache lines
+     */
+    static constexpr std::size_t CACHE_LINE_SIZE = 64u;
+
+    SpscRing()
+        : _head(0u)
+        , _tail(0u)
+        , _waitingTask(nullptr)
+        , _buffer()
+    {}
+
+    /**
+     * @brief Return the maximum number of items that the ring can contain
+     */
+    static constexpr std::size_t capacity()
+    {
+        return N;
+    }
+
+    /**
+     * @brief Return the number of items stored in the ring
+     *
+     * @note The value may already be outdated when returned if the other side is running.
+     */
+    std::size_t size() const
+    {
+        // The tail is loaded first so that it can't pass the head, and the head can pass it by more than N only if
+        // items were popped and pushed between the two loads
+        const std::size_t tail = _tail.load(std::memory_order_acquire);
+        const std::size_t head = _head.load(std::memory_order_acquire);
+        return std::min(head - tail, N);
+    }
+
+    bool empty() const
+    {
+        return size() == 0u;
+    }
+
+    /**
+     * @brief Post an item at the back of the ring from a task
+     *
+     * @note This function never blocks.
+     *
+     * @param item The item to copy in the ring.
+     * @return true if the item was posted, false if the ring is full.
+     */
+    bool push(const T & item)
+    {
+        if (!store(item))
+            return false;
+        TaskHandle_t waitingTask = takeWaitingTask();
+        if (waitingTask != nullptr)
+            xTaskNotifyGive(waitingTask);
+        return true;
+    }
+
+    /**
+     * @brief Post an item at the back of the ring from an interrupt service routine
+     *
+     * @param item The item to copy in the ring.
+     * @param[out] higherPriorityTaskWoken set to true if posting the item unblocked the consumer
+     *             task, and the consumer task has a priority higher than the currently running task.
+     *             If set to true a context switch should be requested before the interrupt is exited,
+     *             for exemple return true in a GpTimer::EventCallBack
+     * @return true if the item was posted, false if the ring is full.
+     */
+    bool pushFromISR(const T & item, bool & higherPriorityTaskWoken)
+    {
+        if (!store(item))
+            return false;
+        TaskHandle_t waitingTask = takeWaitingTask();
+        if (waitingTask != nullptr) {
+            BaseType_t temp = pdFALSE;
+            vTaskNotifyGiveFromISR(waitingTask, &temp);
+            if (temp == pdTRUE)
+                higherPriorityTaskWoken = true;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Remove an item from the front of the ring
+     *
+     * @warning This function uses the notification value of the calling task to wait, and must not
+     *          be called from an interrupt service routine.
+     *
+     * @param ticksToWait The maximum amount of time the task should block waiting for an item should
+     *        the ring be empty at the time of the call. pop() will return immediately if ticksToWait
+     *        is zero and the ring is empty. The time is defined in tick periods so the constant
+     *        portTICK_PERIOD_MS should be used to convert to real time if this is required.
+     * @return A copy of the item if the ring was not empty
+     */
+    std::optional<T> pop(TickType_t ticksToWait)
+    {
+        std::optional<T> item = load();
+        if (item.has_value() || ticksToWait == 0)
+            return item;
+
+        TimeOut_t timeOut;
+        vTaskSetTimeOutState(&timeOut);
+        while (true) {
+            _waitingTask.store(xTaskGetCurrentTaskHandle(), std::memory_order_seq_cst);
+            // Check again after publishing the task handle, the producer may have pushed in between
+            item = load();
+            if (item.has_value()) {
+                _waitingTask.store(nullptr, std::memory_order_relaxed);
+                return item;
+            }
+            ulTaskNotifyTake(pdTRUE, ticksToWait);
+            _waitingTask.store(nullptr, std::memory_order_relaxed);
+            item = load();
+            if (item.has_value() || xTaskCheckForTimeOut(&timeOut, &ticksToWait) == pdTRUE)
+                return item;
+        }
+    }
+
+    /**
+     * @brief Remove an item from the front of the ring without blocking
+     *
+     * @note This function can be called from an interrupt service routine if it is the only consumer.
+     *
+     * @return A copy of the item if the ring was not empty
+     */
+    std::optional<T> popFromISR()
+    {
+        return load();
+    }
+
+private:
+    SpscRing(const SpscRing &) = delete;
+    SpscRing & operator=(const SpscRing &) = delete;
+
+    bool store(const T & item)
+    {
+        const std::size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == N)
+            return false;
+        _buffer[head & (N - 1u)] = item;
+        _head.store(head + 1u, std::memory_order_seq_cst);
+        return true;
+    }
+
+    std::optional<T> load()
+    {
+        const std::size_t tail = _tail.load(std::memory_order_relaxed);
+        if (_head.load(std::memory_order_seq_cst) == tail)
+            return {};
+        T item = _buffer[tail & (N - 1u)];
+        _tail.store(tail + 1u, std::memory_order_release);
+        return item;
+    }
+
+    TaskHandle_t takeWaitingTask()
+    {
+        if (_waitingTask.load(std::memory_order_seq_cst) == nullptr)
+            return nullptr;
+        return _waitingTask.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    // Written by the producer only
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _head;
+    // Written by the consumer only
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _tail;
+    std::atomic<TaskHandle_t> _waitingTask;
+    alignas(CACHE_LINE_SIZE) std::array<T, N> _buffer;
+};
+
+} // idf
+
+#endif // __cpp_exceptions
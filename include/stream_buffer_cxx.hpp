@@ -0,0 +1,409 @@
+#pragma once
+
+#ifdef __cpp_exceptions
+
+#include "esp_exception.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/stream_buffer.h"
+#include "freertos/message_buffer.h"
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace idf {
+
+/**
+ * @brief Byte stream between a single writer and a single reader
+ *
+ * Bytes are copied directly from and to the caller buffers, there is no allocation per send.
+ * A reader blocked in receive() is only woken when at least the trigger level of bytes is available,
+ * so a streaming consumer can process data by blocks instead of per byte.
+ *
+ * @note Stream buffers assume there is only one writer and one reader, several writers or several
+ *       readers must be serialized by the caller.
+ */
+class StreamBuffer
+{
+public:
+    /**
+     * @brief Creates a new stream buffer using dynamically allocated memory
+     *
+     * @param size The total number of bytes the stream buffer will be able to hold at any one time.
+     * @param triggerLevel The number of bytes that must be in the stream buffer before a task that is
+     *        blocked waiting for data is moved out of the blocked state.
+     *
+     * @throw
+     *      - idf::ESPException(ESP_ERR_NO_MEM) if out of memory
+     */
+    explicit StreamBuffer(std::size_t size, std::size_t triggerLevel = 1u)
+        : _handle(xStreamBufferCreate(size, triggerLevel))
+    {
+        if (_handle == nullptr)
+            throw idf::ESPException(ESP_ERR_NO_MEM);
+    }
+
+    /**
+     * @brief Delete the stream buffer
+     */
+    ~StreamBuffer()
+    {
+        vStreamBufferDelete(_handle);
+    }
+
+    /**
+     * @brief Send bytes to the stream buffer
+     *
+     * @warning This function must not be called from an interrupt service routine. See
+     *          sendFromISR() for an alternative which may be used in an ISR.
+     *
+     * @param data The bytes to copy into the stream buffer.
+     * @param ticksToWait The maximum amount of time the task should block waiting for enough space
+     *        to become available for all the bytes. The time is defined in tick periods so the
+     *        constant portTICK_PERIOD_MS should be used to convert to real time if this is required.
+     * @return The number of bytes written, less than data.size() if the timeout expired.
+     */
+    std::size_t send(std::span<const uint8_t> data, TickType_t ticksToWait)
+    {
+        return xStreamBufferSend(_handle, data.data(), data.size(), ticksToWait);
+    }
+
+    /**
+     * @brief Send bytes to the stream buffer from an interrupt service routine
+     *
+     * @param data The bytes to copy into the stream buffer.
+     * @param[out] higherPriorityTaskWoken set to true if sending caused a task to unblock, and the
+     *             unblocked task has a priority higher than the currently running task. If set to
+     *             true a context switch should be requested before the interrupt is exited.
+     * @return The number of bytes written, as many as there was space for.
+     */
+    std::size_t sendFromISR(std::span<const uint8_t> data, bool & higherPriorityTaskWoken)
+    {
+        BaseType_t temp = pdFALSE;
+        std::size_t sent = xStreamBufferSendFromISR(_handle, data.data(), data.size(), &temp);
+        if (temp == pdTRUE)
+            higherPriorityTaskWoken = true;
+        return sent;
+    }
+
+    /**
+     * @brief Receive bytes from the stream buffer
+     *
+     * @warning This function must not be called from an interrupt service routine. See
+     *          receiveFromISR() for an alternative which may be used in an ISR.
+     *
+     * @param[out] data The buffer into which the received bytes are copied.
+     * @param ticksToWait The maximum amount of time the task should block waiting for the trigger
+     *        level of bytes to become available. The time is defined in tick periods so the constant
+     *        portTICK_PERIOD_MS should be used to convert to real time if this is required.
+     * @return The number of bytes written at the front of data, 0 if the timeout expired.
+     */
+    std::size_t receive(std::span<uint8_t> data, TickType_t ticksToWait)
+    {
+        return xStreamBufferReceive(_handle, data.data(), data.size(), ticksToWait);
+    }
+
+    /**
+     * @brief Receive bytes from the stream buffer from an interrupt service routine
+     *
+     * @param[out] data The buffer into which the received bytes are copied.
+     * @param[out] taskWokenByReceive A task may be blocked waiting for space to become available.
+     *             If receiveFromISR causes such a task to unblock taskWokenByReceive will get set to
+     *             true, otherwise taskWokenByReceive will remain unchanged.
+     * @return The number of bytes written at the front of data.
+     */
+    std::size_t receiveFromISR(std::span<uint8_t> data, bool * taskWokenByReceive = nullptr)
+    {
+        BaseType_t temp = pdFALSE;
+        std::size_t received = xStreamBufferReceiveFromISR(_handle, data.data(), data.size(), &temp);
+        if (taskWokenByReceive != nullptr && temp == pdTRUE)
+            *taskWokenByReceive = true;
+        return received;
+    }
+
+    /**
+     * @brief Change the number of bytes that must be available before a blocked reader is woken
+     *
+     * @throw
+     *      - idf::ESPException(ESP_ERR_INVALID_ARG) if triggerLevel is larger than the buffer size
+     */
+    void setTriggerLevel(std::size_t triggerLevel)
+    {
+        if (xStreamBufferSetTriggerLevel(_handle, triggerLevel) != pdPASS)
+            throw idf::ESPException(ESP_ERR_INVALID_ARG);
+    }
+
+    /**
+     * @brief Return the number of bytes that can be read from the stream buffer
+     */
+    std::size_t bytesAvailable() const
+    {
+        return xStreamBufferBytesAvailable(_handle);
+    }
+
+    /**
+     * @brief Return the number of bytes that can be written to the stream buffer
+     */
+    std::size_t spacesAvailable() const
+    {
+        return xStreamBufferSpacesAvailable(_handle);
+    }
+
+    bool isEmpty() const
+    {
+        return xStreamBufferIsEmpty(_handle) == pdTRUE;
+    }
+
+    bool isFull() const
+    {
+        return xStreamBufferIsFull(_handle) == pdTRUE;
+    }
+
+    /**
+     * @brief Reset the stream buffer back to its empty state
+     *
+     * @return false if a task is blocked on the stream buffer, in which case it is not reset.
+     */
+    bool reset()
+    {
+        return xStreamBufferReset(_handle) == pdPASS;
+    }
+
+protected:
+    /**
+     * @brief Take ownership of an already created stream buffer
+     *
+     * @throw
+     *      - idf::ESPException(ESP_ERR_INVALID_ARG) if handle is nullptr, i.e. the creation failed
+     */
+    explicit StreamBuffer(StreamBufferHandle_t handle)
+        : _handle(handle)
+    {
+        if (_handle == nullptr)
+            throw idf::ESPException(ESP_ERR_INVALID_ARG);
+    }
+
+private:
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer & operator=(const StreamBuffer &) = delete;
+
+    StreamBufferHandle_t _handle;
+};
+
+/**
+ * @brief Buffer of variable length messages between a single writer and a single reader
+ *
+ * Each message is received whole, with the length it was sent with. Messages are copied directly from
+ * and to the caller buffers, there is no allocation per message. Each message uses sizeof(size_t)
+ * extra bytes in the buffer to store its length.
+ *
+ * @note Message buffers assume there is only one writer and one reader, several writers or several
+ *       readers must be serialized by the caller.
+ */
+class MessageBuffer
+{
+public:
+    /**
+     * @brief Creates a new message buffer using dynamically allocated memory
+     *
+     * @param size The total number of bytes, messages plus their length, the message buffer will be
+     *        able to hold at any one time.
+     *
+     * @throw
+     *      - idf::ESPException(ESP_ERR_NO_MEM) if out of memory
+     */
+    explicit MessageBuffer(std::size_t size)
+        : _handle(xMessageBufferCreate(size))
+    {
+        if (_handle == nullptr)
+            throw idf::ESPException(ESP_ERR_NO_MEM);
+    }
+
+    /**
+     * @brief Delete the message buffer
+     */
+    ~MessageBuffer()
+    {
+        vMessageBufferDelete(_handle);
+    }
+
+    /**
+     * @brief Send a message to the message buffer
+     *
+     * @warning This function must not be called from an interrupt service routine. See
+     *          sendFromISR() for an alternative which may be used in an ISR.
+     *
+     * @param message The message to copy into the message buffer.
+     * @param ticksToWait The maximum amount of time the task should block waiting for enough space
+     *        to become available for the message. The time is defined in tick periods so the constant
+     *        portTICK_PERIOD_MS should be used to convert to real time if this is required.
+     * @return true if the whole message was written, false if there was not enough space.
+     */
+    bool send(std::span<const uint8_t> message, TickType_t ticksToWait)
+    {
+        return xMessageBufferSend(_handle, message.data(), message.size(), ticksToWait) == message.size();
+    }
+
+    /**
+     * @brief Send a message to the message buffer from an interrupt service routine
+     *
+     * @param message The message to copy into the message buffer.
+     * @param[out] higherPriorityTaskWoken set to true if sending caused a task to unblock, and the
+     *             unblocked task has a priority higher than the currently running task. If set to
+     *             true a context switch should be requested before the interrupt is exited.
+     * @return true if the whole message was written, false if there was not enough space.
+     */
+    bool sendFromISR(std::span<const uint8_t> message, bool & higherPriorityTaskWoken)
+    {
+        BaseType_t temp = pdFALSE;
+        std::size_t sent = xMessageBufferSendFromISR(_handle, message.data(), message.size(), &temp);
+        if (temp == pdTRUE)
+            higherPriorityTaskWoken = true;
+        return sent == message.size();
+    }
+
+    /**
+     * @brief Receive the next message from the message buffer
+     *
+     * @warning This function must not be called from an interrupt service routine. See
+     *          receiveFromISR() for an alternative which may be used in an ISR.
+     *
+     * @param[out] message The buffer into which the message is copied. If it is smaller than the next
+     *             message, the message is left in the message buffer, see nextLengthBytes().
+     * @param ticksToWait The maximum amount of time the task should block waiting for a message. The
+     *        time is defined in tick periods so the constant portTICK_PERIOD_MS should be used to
+     *        convert to real time if this is required.
+     * @return The length of the message written at the front of message, 0 if none was received.
+     */
+    std::size_t receive(std::span<uint8_t> message, TickType_t ticksToWait)
+    {
+        return xMessageBufferReceive(_handle, message.data(), message.size(), ticksToWait);
+    }
+
+    /**
+     * @brief Receive the next message from the message buffer from an interrupt service routine
+     *
+     * @param[out] message The buffer into which the message is copied.
+     * @param[out] taskWokenByReceive A task may be blocked waiting for space to become available.
+     *             If receiveFromISR causes such a task to unblock taskWokenByReceive will get set to
+     *             true, otherwise taskWokenByReceive will remain unchanged.
+     * @return The length of the message written at the front of message, 0 if none was received.
+     */
+    std::size_t receiveFromISR(std::span<uint8_t> message, bool * taskWokenByReceive = nullptr)
+    {
+        BaseType_t temp = pdFALSE;
+        std::size_t received = xMessageBufferReceiveFromISR(_handle, message.data(), message.size(), &temp);
+        if (taskWokenByReceive != nullptr && temp == pdTRUE)
+            *taskWokenByReceive = true;
+        return received;
+    }
+
+    /**
+     * @brief Return the length of the next message, 0 if the message buffer is empty
+     */
+    std::size_t nextLengthBytes() const
+    {
+        return xMessageBufferNextLengthBytes(_handle);
+    }
+
+    /**
+     * @brief Return the number of bytes that can be written, message length included
+     */
+    std::size_t spacesAvailable() const
+    {
+        return xMessageBufferSpacesAvailable(_handle);
+    }
+
+    bool isEmpty() const
+    {
+        return xMessageBufferIsEmpty(_handle) == pdTRUE;
+    }
+
+    bool isFull() const
+    {
+        return xMessageBufferIsFull(_handle) == pdTRUE;
+    }
+
+    /**
+     * @brief Reset the message buffer back to its empty state
+     *
+     * @return false if a task is blocked on the message buffer, in which case it is not reset.
+     */
+    bool reset()
+    {
+        return xMessageBufferReset(_handle) == pdPASS;
+    }
+
+protected:
+    /**
+     * @brief Take ownership of an already created message buffer
+     *
+     * @throw
+     *      - idf::ESPException(ESP_ERR_INVALID_ARG) if handle is nullptr, i.e. the creation failed
+     */
+    explicit MessageBuffer(MessageBufferHandle_t handle)
+        : _handle(handle)
+    {
+        if (_handle == nullptr)
+            throw idf::ESPException(ESP_ERR_INVALID_ARG);
+    }
+
+private:
+    MessageBuffer(const MessageBuffer &) = delete;
+    MessageBuffer & operator=(const MessageBuffer &) = delete;
+
+    MessageBufferHandle_t _handle;
+};
+
+namespace detail {
+
+/**
+ * @brief Memory of a statically allocated stream or message buffer.
+ *
+ * Inherited before StreamBuffer or MessageBuffer so that it is constructed first.
+ */
+template <std::size_t Size, typename Control>
+struct BufferStorage
+{
+    // FreeRTOS needs one more byte than the buffer size
+    std::array<uint8_t, Size + 1u> _storage;
+    Control _control;
+};
+
+} // detail
+
+/**
+ * @brief StreamBuffer whose memory is part of the object, no heap allocation is made
+ *
+ * @tparam Size The total number of bytes the stream buffer will be able to hold at any one time.
+ */
+template <std::size_t Size>
+class StaticStreamBuffer : private detail::BufferStorage<Size, StaticStreamBuffer_t>, public StreamBuffer
+{
+public:
+    /**
+     * @param triggerLevel The number of bytes that must be in the stream buffer before a task that is
+     *        blocked waiting for data is moved out of the blocked state.
+     */
+    explicit StaticStreamBuffer(std::size_t triggerLevel = 1u)
+        : StreamBuffer(xStreamBufferCreateStatic(Size, triggerLevel, this->_storage.data(), &this->_control))
+    {}
+};
+
+/**
+ * @brief MessageBuffer whose memory is part of the object, no heap allocation is made
+ *
+ * @tparam Size The total number of bytes, messages plus their length, the message buffer will be
+ *         able to hold at any one time.
+ */
+template <std::size_t Size>
+class StaticMessageBuffer : private detail::BufferStorage<Size, StaticMessageBuffer_t>, public MessageBuffer
+{
+public:
+    StaticMessageBuffer()
+        : MessageBuffer(xMessageBufferCreateStatic(Size, this->_storage.data(), &this->_control))
+    {}
+};
+
+} // idf
+
+#endif // __cpp_exceptions
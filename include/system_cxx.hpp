@@ -32,7 +32,7 @@ protected:
     constexpr StrongValue(ValueT value_arg) : value(value_arg) { }
 
     template<typename RawType = ValueT>
-    RawType get_value() const {
+    constexpr RawType get_value() const {
         return static_cast<RawType>(value);
     }
 
@@ -51,12 +51,12 @@ protected:
 public:
     using StrongValue<ValueT>::get_value;
 
-    bool operator==(const StrongValueComparable<ValueT> &other_gpio) const
+    constexpr bool operator==(const StrongValueComparable<ValueT> &other_gpio) const
     {
         return get_value() == other_gpio.get_value();
     }
 
-    bool operator!=(const StrongValueComparable<ValueT> &other_gpio) const
+    constexpr bool operator!=(const StrongValueComparable<ValueT> &other_gpio) const
     {
         return get_value() != other_gpio.get_value();
     }
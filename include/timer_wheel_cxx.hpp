@@ -0,0 +1,172 @@
+#pragma once
+
+#ifdef __cpp_exceptions
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include "esp_timer_cxx.hpp"
+
+namespace idf {
+
+namespace esp_timer {
+
+/**
+ * @brief Many lightweight one-shot timers multiplexed on a single ESPTimer.
+ *
+ * The timers are kept in a hierarchical timing wheel: 4 levels of 64 slots, each slot being an intrusive doubly linked
+ * list. Starting, restarting and stopping a timer only link or unlink it, in O(1) and without allocation, whatever
+ * the number of armed timers. The ESPTimer ticks periodically only while at least one timer is armed, and all the
+ * timers expired during a tick are called in a batch from the esp_timer task.
+ *
+ * The timeouts are rounded up to the tick period: a timer never expires early, and at most one tick period late
+ * (plus the esp_timer task latency).
+ *
+ * The wheel covers 64^4 = 2^24 ticks (about 4.66 hours with 1 ms ticks). The timers expiring further are kept in an
+ * overflow list, which is sorted into the wheel each time it wraps around.
+ */
+class TimerWheel {
+    /**
+     * Node of a circular doubly linked list, a list head is a Link which is not a Timer.
+     */
+    struct Link {
+        Link *prev;
+        Link *next;
+    };
+
+public:
+    /**
+     * @brief A one-shot timer of a TimerWheel.
+     *
+     * The timer must not outlive its wheel. It is stopped by its destructor.
+     */
+    class Timer : private Link {
+    public:
+        /**
+         * @brief Callback called from the esp_timer task when the timer expires.
+         */
+        using CallBack = void (*)(void *arg);
+
+        /**
+         * @param wheel The wheel running the timer.
+         * @param callback The timeout callback.
+         * @param arg The argument given to the callback.
+         *
+         * @throws ESPException with error ESP_ERR_INVALID_ARG if callback is null.
+         */
+        Timer(TimerWheel &wheel, CallBack callback, void *arg = nullptr);
+
+        /**
+         * @brief Stop the timer if necessary.
+         */
+        ~Timer();
+
+        /**
+         * @brief Start the timer, or restart it with a new timeout if it is already armed.
+         *
+         * @param timeout Timeout relative to the current moment.
+         *
+         * @throws ESPException if the underlying ESPTimer can't be started.
+         */
+        void start(std::chrono::microseconds timeout);
+
+        /**
+         * @brief Stop the timer, nothing is done if it is not armed.
+         *
+         * @note After stop() returns, the callback won't be called, unless it is already running.
+         */
+        void stop() noexcept;
+
+        /**
+         * @brief Return true if the timer is armed.
+         */
+        bool is_active() const noexcept;
+
+    private:
+        Timer(const Timer&) = delete;
+        Timer &operator=(const Timer&) = delete;
+
+        friend class TimerWheel;
+
+        TimerWheel &wheel;
+        CallBack callback;
+        void *arg;
+        uint64_t expiry_tick;
+    };
+
+    /**
+     * @param tick_period The resolution of the timers.
+     * @param timer_name The name of the underlying ESPTimer (optional). This is for debugging using
+     *        \c esp_timer_dump().
+     *
+     * @throws ESPException
+     *              - ESP_ERR_INVALID_ARG if tick_period is not positive
+     *              - if the underlying ESPTimer can't be created
+     */
+    TimerWheel(std::chrono::microseconds tick_period = std::chrono::milliseconds(1),
+            const std::string &timer_name = "TimerWheel");
+
+    /**
+     * @brief Return the number of armed timers.
+     */
+    std::size_t active_count() const;
+
+private:
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel &operator=(const TimerWheel&) = delete;
+
+    static constexpr uint32_t SLOT_BITS = 6u;
+    static constexpr uint32_t SLOT_COUNT = 1u << SLOT_BITS;
+    static constexpr uint32_t LEVEL_COUNT = 4u;
+    static constexpr uint32_t WHEEL_BITS = LEVEL_COUNT * SLOT_BITS;
+
+    static void init(Link &list) noexcept;
+    static void push_back(Link &list, Link &link) noexcept;
+    static void unlink(Link &link) noexcept;
+
+    uint64_t current_tick() const;
+    void insert(Timer &timer) noexcept;
+    void start(Timer &timer, std::chrono::microseconds timeout);
+    void stop(Timer &timer) noexcept;
+    void on_tick();
+
+    const int64_t tick_period_us;
+
+    /**
+     * Protects all the following members and the links of the timers.
+     */
+    mutable std::mutex wheel_mutex;
+
+    /**
+     * Time of the tick 0 in microseconds, as returned by \c get_time().
+     */
+    int64_t epoch_us;
+
+    /**
+     * Last processed tick.
+     */
+    uint64_t tick;
+
+    std::size_t armed;
+    std::array<std::array<Link, SLOT_COUNT>, LEVEL_COUNT> slots;
+
+    /**
+     * Timers expired during the current tick and not called yet.
+     */
+    Link expired;
+
+    /**
+     * Timers expiring after the range of the wheel, i.e. in a later block of 2^WHEEL_BITS ticks.
+     */
+    Link overflow;
+
+    ESPTimer ticker;
+    bool running;
+};
+
+} // esp_timer
+
+} // idf
+
+#endif // __cpp_exceptions
@@ -0,0 +1,231 @@
+#ifdef __cpp_exceptions
+
+#include <algorithm>
+#include <limits>
+#include "timer_wheel_cxx.hpp"
+
+using namespace std;
+
+namespace idf {
+
+namespace esp_timer {
+
+TimerWheel::Timer::Timer(TimerWheel &wheel, CallBack callback, void *arg)
+    : Link{nullptr, nullptr}, wheel(wheel), callback(callback), arg(arg), expiry_tick(0u)
+{
+    if (callback == nullptr) {
+        throw ESPException(ESP_ERR_INVALID_ARG);
+    }
+}
+
+TimerWheel::Timer::~Timer()
+{
+    stop();
+}
+
+void TimerWheel::Timer::start(chrono::microseconds timeout)
+{
+    wheel.start(*this, timeout);
+}
+
+void TimerWheel::Timer::stop() noexcept
+{
+    wheel.stop(*this);
+}
+
+bool TimerWheel::Timer::is_active() const noexcept
+{
+    lock_guard<std::mutex> lock(wheel.wheel_mutex);
+    return next != nullptr;
+}
+
+TimerWheel::TimerWheel(chrono::microseconds tick_period, const string &timer_name)
+    : tick_period_us(tick_period.count()),
+    wheel_mutex(),
+    epoch_us(0),
+    tick(0u),
+    armed(0u),
+    slots(),
+    expired(),
+    overflow(),
+    ticker([this]() { on_tick(); }, timer_name),
+    running(false)
+{
+    if (tick_period_us <= 0) {
+        throw ESPException(ESP_ERR_INVALID_ARG);
+    }
+    for (auto &level : slots) {
+        for (Link &slot : level) {
+            init(slot);
+        }
+    }
+    init(expired);
+    init(overflow);
+}
+
+size_t TimerWheel::active_count() const
+{
+    lock_guard<std::mutex> lock(wheel_mutex);
+    return armed;
+}
+
+void TimerWheel::init(Link &list) noexcept
+{
+    list.prev = &list;
+    list.next = &list;
+}
+
+void TimerWheel::push_back(Link &list, Link &link) noexcept
+{
+    link.prev = list.prev;
+    link.next = &list;
+    list.prev->next = &link;
+    list.prev = &link;
+}
+
+void TimerWheel::unlink(Link &link) noexcept
+{
+    link.prev->next = link.next;
+    link.next->prev = link.prev;
+    link.prev = nullptr;
+    link.next = nullptr;
+}
+
+uint64_t TimerWheel::current_tick() const
+{
+    return static_cast<uint64_t>(get_time().count() - epoch_us) / tick_period_us;
+}
+
+void TimerWheel::insert(Timer &timer) noexcept
+{
+    if ((timer.expiry_tick >> WHEEL_BITS) != (tick >> WHEEL_BITS)) {
+        // Beyond the range of the top level, whose slot index would wrap around to a slot reached too early
+        push_back(overflow, timer);
+        return;
+    }
+
+    // The level is given by the highest group of SLOT_BITS bits which differs between the expiry and the current
+    // tick, so that the slot of the timer is reached by the cascade before the timer expires.
+    uint32_t level = 0u;
+    while (level < LEVEL_COUNT - 1u
+            && (timer.expiry_tick >> ((level + 1u) * SLOT_BITS)) != (tick >> ((level + 1u) * SLOT_BITS))) {
+        level++;
+    }
+    const uint32_t slot = (timer.expiry_tick >> (level * SLOT_BITS)) & (SLOT_COUNT - 1u);
+    push_back(slots[level][slot], timer);
+}
+
+void TimerWheel::start(Timer &timer, chrono::microseconds timeout)
+{
+    lock_guard<std::mutex> lock(wheel_mutex);
+    if (!running) {
+        // Resynchronize the tick count with the time, it did not advance while the ESPTimer was stopped
+        epoch_us = get_time().count() - static_cast<int64_t>(tick) * tick_period_us;
+    }
+
+    if (timer.next != nullptr) {
+        unlink(timer);
+    } else {
+        armed++;
+    }
+
+    // Round up so that the timer never expires early, and saturate the far timeouts instead of overflowing
+    const int64_t elapsed_us = get_time().count() - epoch_us;
+    const int64_t expiry_us = elapsed_us
+            + clamp<int64_t>(timeout.count(), 0, numeric_limits<int64_t>::max() - elapsed_us - tick_period_us);
+    timer.expiry_tick = max<uint64_t>((expiry_us + tick_period_us - 1) / tick_period_us, tick + 1u);
+    insert(timer);
+
+    if (!running) {
+        try {
+            ticker.start_periodic(chrono::microseconds(tick_period_us));
+        } catch (const ESPException &) {
+            unlink(timer);
+            armed--;
+            throw;
+        }
+        running = true;
+    }
+}
+
+void TimerWheel::stop(Timer &timer) noexcept
+{
+    lock_guard<std::mutex> lock(wheel_mutex);
+    if (timer.next != nullptr) {
+        unlink(timer);
+        armed--;
+    }
+}
+
+void TimerWheel::on_tick()
+{
+    unique_lock<std::mutex> lock(wheel_mutex);
+    if (!running) {
+        // Late call of a tick dispatched before the ESPTimer was stopped
+        return;
+    }
+    const uint64_t target = current_tick();
+    while (tick < target && armed != 0u) {
+        tick++;
+        if ((tick & ((1ull << WHEEL_BITS) - 1u)) == 0u) {
+            // The wheel wrapped around: move the overflow timers to a temporary list first, so that the ones still
+            // beyond the new range are put back into overflow without being drained again
+            Link pending;
+            init(pending);
+            while (overflow.next != &overflow) {
+                Link &link = *overflow.next;
+                unlink(link);
+                push_back(pending, link);
+            }
+            while (pending.next != &pending) {
+                Timer &timer = static_cast<Timer &>(*pending.next);
+                unlink(timer);
+                insert(timer);
+            }
+        }
+
+        // Cascade the timers of the higher levels whose slot is reached, from the highest level
+        for (uint32_t level = LEVEL_COUNT - 1u; level > 0u; level--) {
+            if ((tick & ((1ull << (level * SLOT_BITS)) - 1u)) != 0u) {
+                continue;
+            }
+            Link &slot = slots[level][(tick >> (level * SLOT_BITS)) & (SLOT_COUNT - 1u)];
+            while (slot.next != &slot) {
+                Timer &timer = static_cast<Timer &>(*slot.next);
+                unlink(timer);
+                insert(timer);
+            }
+        }
+
+        Link &slot = slots[0][tick & (SLOT_COUNT - 1u)];
+        while (slot.next != &slot) {
+            Link &link = *slot.next;
+            unlink(link);
+            push_back(expired, link);
+        }
+
+        // Call the expired timers without the lock, so that they can be started or stopped by the callbacks
+        while (expired.next != &expired) {
+            Timer &timer = static_cast<Timer &>(*expired.next);
+            unlink(timer);
+            armed--;
+            const Timer::CallBack callback = timer.callback;
+            void *arg = timer.arg;
+            lock.unlock();
+            callback(arg);
+            lock.lock();
+        }
+    }
+    // Don't tick while no timer is armed
+    if (armed == 0u) {
+        tick = max(tick, target);
+        ticker.try_stop();
+        running = false;
+    }
+}
+
+} // esp_timer
+
+} // idf
+
+#endif // __cpp_exceptions